@@ -5,8 +5,10 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <script/signingprovider.h>
 #include <test/util/transaction_utils.h>
+#include <tinyformat.h>
 
 #include <vector>
 
@@ -51,4 +53,32 @@ static void CCoinsCaching(benchmark::Bench& bench)
     ECC_Stop();
 }
 
+// Lookups of random cached coins in a CCoinsViewCache holding many P2WPKH
+// coins. The memory the cache uses per coin, as reported by
+// DynamicMemoryUsage(), is shown in the benchmark name.
+static void CCoinsCachingLookup(benchmark::Bench& bench)
+{
+    static const size_t NUM_COINS = 100000;
+
+    FastRandomContext rng(true);
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(NUM_COINS);
+    for (size_t i = 0; i < NUM_COINS; ++i) {
+        CScript script = CScript() << OP_0 << rng.randbytes(20);
+        outpoints.emplace_back(rng.rand256(), rng.randrange(4));
+        coins.AddCoin(outpoints.back(), Coin(CTxOut(COIN, script), 1, false), false);
+    }
+    bench.name(strprintf("CCoinsCachingLookup (%u bytes/coin)", coins.DynamicMemoryUsage() / coins.GetCacheSize()));
+
+    size_t i = 0;
+    bench.unit("lookup").run([&] {
+        const Coin& coin = coins.AccessCoin(outpoints[i]);
+        assert(!coin.IsSpent());
+        i = (i + 7919) % NUM_COINS;
+    });
+}
+
 BENCHMARK(CCoinsCaching);
+BENCHMARK(CCoinsCachingLookup);
@@ -4,11 +4,20 @@
 
 #include <bench/bench.h>
 #include <checkqueue.h>
+#include <crypto/sha256.h>
 #include <key.h>
 #include <prevector.h>
 #include <pubkey.h>
 #include <random.h>
+#include <script/interpreter.h>
+#include <script/sigcache.h>
+#include <uint256.h>
 #include <util/system.h>
+#include <validation.h>
+
+#include <secp256k1.h>
+#include <secp256k1_extrakeys.h>
+#include <secp256k1_schnorrsig.h>
 
 #include <boost/thread/thread.hpp>
 
@@ -75,3 +84,155 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::Bench& bench)
     ECC_Stop();
 }
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+
+static const size_t SCHNORR_TXS = 100;
+static const size_t SCHNORR_INPUTS_PER_TX = 20;
+
+//! Records the sighash of the Schnorr signature it is asked to verify.
+class SchnorrSighashRecorder : public TransactionSignatureChecker
+{
+    uint256& m_sighash;
+
+public:
+    SchnorrSighashRecorder(const CTransaction* tx, unsigned int n_in, const CAmount& amount, const PrecomputedTransactionData& txdata, uint256& sighash) :
+        TransactionSignatureChecker(tx, n_in, amount, txdata), m_sighash(sighash) {}
+
+    bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const override
+    {
+        m_sighash = sighash;
+        return true;
+    }
+};
+
+// Verifies a block's worth of taproot key path spends through the script
+// check queue, with the checks run through batch type B. The unit is one
+// signature.
+template <typename B>
+static void CCheckQueueSchnorr(benchmark::Bench& bench)
+{
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+    InitSignatureCache();
+    secp256k1_context* sign_ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    const unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_TAPROOT;
+
+    std::vector<CTransactionRef> txs;
+    std::vector<std::vector<CTxOut>> spent_outputs(SCHNORR_TXS);
+    std::vector<PrecomputedTransactionData> txdata(SCHNORR_TXS);
+    for (size_t i = 0; i < SCHNORR_TXS; ++i) {
+        CMutableTransaction mtx;
+        std::vector<secp256k1_keypair> keypairs(SCHNORR_INPUTS_PER_TX);
+        for (secp256k1_keypair& keypair : keypairs) {
+            const uint256 seckey = GetRandHash();
+            secp256k1_xonly_pubkey xonly;
+            unsigned char xonly_bytes[32];
+            bool ret = secp256k1_keypair_create(sign_ctx, &keypair, seckey.begin());
+            ret &= secp256k1_keypair_xonly_pub(sign_ctx, &xonly, nullptr, &keypair);
+            ret &= secp256k1_xonly_pubkey_serialize(sign_ctx, xonly_bytes, &xonly);
+            assert(ret);
+            spent_outputs[i].emplace_back(1000, CScript() << OP_1 << std::vector<unsigned char>(xonly_bytes, xonly_bytes + 32));
+            mtx.vin.emplace_back(COutPoint(GetRandHash(), 0));
+            mtx.vin.back().scriptWitness.stack.emplace_back(64);
+        }
+        mtx.vout.emplace_back(1000 * SCHNORR_INPUTS_PER_TX, CScript() << OP_TRUE);
+
+        // Key path signatures do not commit to the witness, so they can be
+        // computed against the transaction with placeholder signatures.
+        const CTransaction unsigned_tx(mtx);
+        PrecomputedTransactionData unsigned_txdata;
+        unsigned_txdata.Init(unsigned_tx, std::vector<CTxOut>(spent_outputs[i]));
+        for (size_t j = 0; j < SCHNORR_INPUTS_PER_TX; ++j) {
+            uint256 sighash;
+            const CTxOut& prevout = spent_outputs[i][j];
+            bool ret = VerifyScript(CScript(), prevout.scriptPubKey, &unsigned_tx.vin[j].scriptWitness, flags, SchnorrSighashRecorder(&unsigned_tx, j, prevout.nValue, unsigned_txdata, sighash), nullptr);
+            ret &= secp256k1_schnorrsig_sign(sign_ctx, mtx.vin[j].scriptWitness.stack[0].data(), sighash.begin(), &keypairs[j], nullptr, nullptr);
+            assert(ret);
+        }
+        txs.push_back(MakeTransactionRef(std::move(mtx)));
+        txdata[i].Init(*txs.back(), std::vector<CTxOut>(spent_outputs[i]));
+    }
+    secp256k1_context_destroy(sign_ctx);
+
+    CCheckQueue<CScriptCheck, B> queue{QUEUE_BATCH_SIZE};
+    boost::thread_group tg;
+    for (auto x = 0; x < GetNumCores() - 1; ++x) {
+       tg.create_thread([&]{queue.Thread();});
+    }
+
+    bench.batch(SCHNORR_TXS * SCHNORR_INPUTS_PER_TX).unit("signature").run([&] {
+        CCheckQueueControl<CScriptCheck, B> control(&queue);
+        for (size_t i = 0; i < SCHNORR_TXS; ++i) {
+            std::vector<CScriptCheck> checks;
+            checks.reserve(SCHNORR_INPUTS_PER_TX);
+            for (size_t j = 0; j < SCHNORR_INPUTS_PER_TX; ++j) {
+                checks.emplace_back(spent_outputs[i][j], *txs[i], j, flags, /* cacheStore */ false, &txdata[i]);
+            }
+            control.Add(checks);
+        }
+        bool ret = control.Wait();
+        assert(ret);
+    });
+    tg.interrupt_all();
+    tg.join_all();
+    ECC_Stop();
+}
+
+static void CCheckQueueSchnorrBatch(benchmark::Bench& bench) { CCheckQueueSchnorr<CScriptCheckBatch>(bench); }
+static void CCheckQueueSchnorrNoBatch(benchmark::Bench& bench) { CCheckQueueSchnorr<CCheckQueueNoBatch>(bench); }
+
+BENCHMARK(CCheckQueueSchnorrBatch);
+BENCHMARK(CCheckQueueSchnorrNoBatch);
+
+static const size_t SCALING_TXS = 500;
+static const size_t SCALING_INPUTS_PER_TX = 4;
+
+// Runs a block's worth of checks that each cost a few microseconds, like a
+// signature check, on a queue with the given total number of threads
+// (including the master). Compare the results to see how the queue scales.
+template <int THREADS>
+static void CCheckQueueScaling(benchmark::Bench& bench)
+{
+    struct HashJob {
+        uint256 data;
+        bool operator()()
+        {
+            for (int i = 0; i < 8; ++i) {
+                CSHA256().Write(data.begin(), data.size()).Finalize(data.begin());
+            }
+            return true;
+        }
+        void swap(HashJob& x) { std::swap(data, x.data); }
+    };
+    CCheckQueue<HashJob> queue{QUEUE_BATCH_SIZE};
+    boost::thread_group tg;
+    for (auto x = 0; x < THREADS - 1; ++x) {
+       tg.create_thread([&]{queue.Thread();});
+    }
+
+    bench.minEpochIterations(10).batch(SCALING_TXS * SCALING_INPUTS_PER_TX).unit("job").run([&] {
+        CCheckQueueControl<HashJob> control(&queue);
+        for (size_t i = 0; i < SCALING_TXS; ++i) {
+            std::vector<HashJob> vChecks(SCALING_INPUTS_PER_TX);
+            control.Add(vChecks);
+        }
+        control.Wait();
+    });
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void CCheckQueueScaling1(benchmark::Bench& bench) { CCheckQueueScaling<1>(bench); }
+static void CCheckQueueScaling2(benchmark::Bench& bench) { CCheckQueueScaling<2>(bench); }
+static void CCheckQueueScaling4(benchmark::Bench& bench) { CCheckQueueScaling<4>(bench); }
+static void CCheckQueueScaling8(benchmark::Bench& bench) { CCheckQueueScaling<8>(bench); }
+static void CCheckQueueScaling16(benchmark::Bench& bench) { CCheckQueueScaling<16>(bench); }
+static void CCheckQueueScaling32(benchmark::Bench& bench) { CCheckQueueScaling<32>(bench); }
+static void CCheckQueueScaling64(benchmark::Bench& bench) { CCheckQueueScaling<64>(bench); }
+
+BENCHMARK(CCheckQueueScaling1);
+BENCHMARK(CCheckQueueScaling2);
+BENCHMARK(CCheckQueueScaling4);
+BENCHMARK(CCheckQueueScaling8);
+BENCHMARK(CCheckQueueScaling16);
+BENCHMARK(CCheckQueueScaling32);
+BENCHMARK(CCheckQueueScaling64);
@@ -0,0 +1,72 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <script/interpreter.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+
+#include <memory>
+#include <vector>
+
+static const size_t BLOCK_TXS = 2000;
+
+// Gets the precomputed transaction data of a block's worth of transactions
+// the way ConnectBlock does: from the mempool if the transaction is in it,
+// otherwise by hashing the transaction. Each transaction spends a segwit v0
+// and a taproot output, so both sets of hashes are needed.
+static void PrecomputeBlockTxData(benchmark::Bench& bench, bool full_mempool)
+{
+    TestingSetup test_setup{
+        CBaseChainParams::REGTEST,
+        /* extra_args */ {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+
+    std::vector<CTransactionRef> txs;
+    std::vector<std::vector<CTxOut>> spent_outputs(BLOCK_TXS);
+    for (size_t i = 0; i < BLOCK_TXS; ++i) {
+        CMutableTransaction mtx;
+        for (int j = 0; j < 2; ++j) {
+            mtx.vin.emplace_back(COutPoint(GetRandHash(), j));
+            mtx.vin.back().scriptWitness.stack.emplace_back(64);
+            mtx.vout.emplace_back(COIN, CScript() << OP_0 << std::vector<unsigned char>(20));
+        }
+        spent_outputs[i].emplace_back(COIN, CScript() << OP_0 << std::vector<unsigned char>(20));
+        spent_outputs[i].emplace_back(COIN, CScript() << OP_1 << std::vector<unsigned char>(32));
+        txs.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+
+    CTxMemPool pool;
+    if (full_mempool) {
+        LOCK2(cs_main, pool.cs);
+        for (size_t i = 0; i < BLOCK_TXS; ++i) {
+            CTxMemPoolEntry entry(txs[i], 1000, 0, 10.0, 1, 0, false, 4, LockPoints());
+            auto txdata = std::make_shared<PrecomputedTransactionData>();
+            txdata->Init(*txs[i], std::vector<CTxOut>(spent_outputs[i]));
+            entry.SetPrecomputedTxData(std::move(txdata));
+            pool.addUnchecked(entry);
+        }
+    }
+
+    bench.minEpochIterations(10).batch(BLOCK_TXS).unit("tx").run([&] {
+        std::vector<std::shared_ptr<PrecomputedTransactionData>> txsdata(BLOCK_TXS);
+        for (size_t i = 0; i < BLOCK_TXS; ++i) {
+            txsdata[i] = pool.GetPrecomputedTxData(txs[i]->GetWitnessHash());
+            if (!txsdata[i]) {
+                txsdata[i] = std::make_shared<PrecomputedTransactionData>();
+                txsdata[i]->Init(*txs[i], std::vector<CTxOut>(spent_outputs[i]));
+            }
+        }
+    });
+}
+
+static void PrecomputeBlockTxDataFullMempool(benchmark::Bench& bench) { PrecomputeBlockTxData(bench, true); }
+static void PrecomputeBlockTxDataEmptyMempool(benchmark::Bench& bench) { PrecomputeBlockTxData(bench, false); }
+
+BENCHMARK(PrecomputeBlockTxDataFullMempool);
+BENCHMARK(PrecomputeBlockTxDataEmptyMempool);
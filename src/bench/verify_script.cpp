@@ -7,6 +7,7 @@
 #if defined(HAVE_CONSENSUS_LIB)
 #include <script/bitcoinconsensus.h>
 #endif
+#include <policy/policy.h>
 #include <script/script.h>
 #include <script/standard.h>
 #include <streams.h>
@@ -75,6 +76,53 @@ static void VerifyScriptBench(benchmark::Bench& bench)
     ECC_Stop();
 }
 
+namespace {
+/** Accepts every signature, to measure the interpreter without the cost of signature verification. */
+class AcceptingSignatureChecker : public BaseSignatureChecker
+{
+public:
+    bool CheckECDSASignature(const std::vector<unsigned char>& sig, const std::vector<unsigned char>& pubkey, const CScript& script_code, SigVersion sigversion) const override { return true; }
+};
+} // namespace
+
+// Overhead of the interpreter itself on P2PKH and P2WPKH spends, with and
+// without the fast paths for these templates.
+static void VerifyScriptOverhead(benchmark::Bench& bench, bool witness, bool generic)
+{
+    const int flags = STANDARD_SCRIPT_VERIFY_FLAGS;
+    std::vector<unsigned char> sig(72, 0x30);
+    sig.back() = SIGHASH_ALL;
+    std::vector<unsigned char> pubkey(33, 0x02);
+    uint160 pubkeyHash;
+    CHash160().Write(pubkey).Finalize(pubkeyHash);
+
+    CScript scriptPubKey;
+    CScript scriptSig;
+    CScriptWitness scriptWitness;
+    if (witness) {
+        scriptPubKey << OP_0 << ToByteVector(pubkeyHash);
+        scriptWitness.stack = {sig, pubkey};
+    } else {
+        scriptPubKey << OP_DUP << OP_HASH160 << ToByteVector(pubkeyHash) << OP_EQUALVERIFY << OP_CHECKSIG;
+        scriptSig << sig << pubkey;
+    }
+    // Signature encoding is not checked by the accepting checker.
+    const unsigned int check_flags = flags & ~(SCRIPT_VERIFY_DERSIG | SCRIPT_VERIFY_STRICTENC | SCRIPT_VERIFY_LOW_S);
+    const AcceptingSignatureChecker checker;
+    bench.run([&] {
+        ScriptError err;
+        bool success = generic ? VerifyScriptGeneric(scriptSig, scriptPubKey, &scriptWitness, check_flags, checker, &err)
+                               : VerifyScript(scriptSig, scriptPubKey, &scriptWitness, check_flags, checker, &err);
+        assert(err == SCRIPT_ERR_OK);
+        assert(success);
+    });
+}
+
+static void VerifyScriptP2PKHOverhead(benchmark::Bench& bench) { VerifyScriptOverhead(bench, false, false); }
+static void VerifyScriptP2PKHOverheadGeneric(benchmark::Bench& bench) { VerifyScriptOverhead(bench, false, true); }
+static void VerifyScriptP2WPKHOverhead(benchmark::Bench& bench) { VerifyScriptOverhead(bench, true, false); }
+static void VerifyScriptP2WPKHOverheadGeneric(benchmark::Bench& bench) { VerifyScriptOverhead(bench, true, true); }
+
 static void VerifyNestedIfScript(benchmark::Bench& bench)
 {
     std::vector<std::vector<unsigned char>> stack;
@@ -97,4 +145,8 @@ static void VerifyNestedIfScript(benchmark::Bench& bench)
 }
 
 BENCHMARK(VerifyScriptBench);
+BENCHMARK(VerifyScriptP2PKHOverhead);
+BENCHMARK(VerifyScriptP2PKHOverheadGeneric);
+BENCHMARK(VerifyScriptP2WPKHOverhead);
+BENCHMARK(VerifyScriptP2WPKHOverheadGeneric);
 BENCHMARK(VerifyNestedIfScript);
@@ -0,0 +1,85 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockcache.h>
+
+#include <core_memusage.h>
+#include <memusage.h>
+#include <primitives/block.h>
+
+void CBlockReadCache::SetMaxSize(size_t max_bytes)
+{
+    LOCK(m_mutex);
+    m_max_bytes = max_bytes;
+    Trim();
+}
+
+std::shared_ptr<const CBlock> CBlockReadCache::GetBlock(const uint256& hash)
+{
+    return std::static_pointer_cast<const CBlock>(Get({hash, false}));
+}
+
+std::shared_ptr<const std::vector<uint8_t>> CBlockReadCache::GetRawBlock(const uint256& hash)
+{
+    return std::static_pointer_cast<const std::vector<uint8_t>>(Get({hash, true}));
+}
+
+void CBlockReadCache::AddBlock(const uint256& hash, std::shared_ptr<const CBlock> block)
+{
+    const size_t usage = RecursiveDynamicUsage(block);
+    Add({hash, false}, std::move(block), usage);
+}
+
+void CBlockReadCache::AddRawBlock(const uint256& hash, std::shared_ptr<const std::vector<uint8_t>> block)
+{
+    const size_t usage = memusage::DynamicUsage(block) + memusage::DynamicUsage(*block);
+    Add({hash, true}, std::move(block), usage);
+}
+
+CBlockReadCache::Stats CBlockReadCache::GetStats() const
+{
+    LOCK(m_mutex);
+    Stats stats;
+    stats.entries = m_entries.size();
+    stats.bytes = m_bytes;
+    stats.max_bytes = m_max_bytes;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    return stats;
+}
+
+std::shared_ptr<const void> CBlockReadCache::Get(const std::pair<uint256, bool>& key)
+{
+    LOCK(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        ++m_misses;
+        return nullptr;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->data;
+}
+
+void CBlockReadCache::Add(const std::pair<uint256, bool>& key, std::shared_ptr<const void> data, size_t usage)
+{
+    LOCK(m_mutex);
+    // Entries larger than a quarter of the cache would push out too much.
+    if (usage > m_max_bytes / 4 || m_index.count(key)) return;
+    m_entries.push_front(Entry{key, std::move(data), usage});
+    m_index.emplace(key, m_entries.begin());
+    m_bytes += usage;
+    Trim();
+}
+
+void CBlockReadCache::Trim()
+{
+    AssertLockHeld(m_mutex);
+    while (m_bytes > m_max_bytes) {
+        const Entry& entry = m_entries.back();
+        m_bytes -= entry.usage;
+        m_index.erase(entry.key);
+        m_entries.pop_back();
+    }
+}
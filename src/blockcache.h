@@ -0,0 +1,76 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKCACHE_H
+#define BITCOIN_BLOCKCACHE_H
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class CBlock;
+
+/**
+ * Size-bounded cache of recently read blocks, so that blocks requested over
+ * and over (for example by several peers syncing from us at once) are read
+ * from disk and deserialized only once.
+ *
+ * Blocks are cached both deserialized and as stored on disk, independently,
+ * and the least recently used are dropped first. Everything handed out is
+ * immutable and stays valid after it is dropped from the cache.
+ */
+class CBlockReadCache
+{
+public:
+    struct Stats {
+        size_t entries{0};
+        size_t bytes{0};
+        size_t max_bytes{0};
+        uint64_t hits{0};
+        uint64_t misses{0};
+    };
+
+    explicit CBlockReadCache(size_t max_bytes) : m_max_bytes(max_bytes) {}
+
+    /** Change the memory limit, dropping entries if needed. 0 disables caching. */
+    void SetMaxSize(size_t max_bytes);
+
+    /** Look up a cached block. Counts a hit or a miss. */
+    std::shared_ptr<const CBlock> GetBlock(const uint256& hash);
+    std::shared_ptr<const std::vector<uint8_t>> GetRawBlock(const uint256& hash);
+
+    /** Add a block that was just read. */
+    void AddBlock(const uint256& hash, std::shared_ptr<const CBlock> block);
+    void AddRawBlock(const uint256& hash, std::shared_ptr<const std::vector<uint8_t>> block);
+
+    Stats GetStats() const;
+
+private:
+    struct Entry {
+        std::pair<uint256, bool> key; //!< Block hash, and whether the data is raw
+        std::shared_ptr<const void> data;
+        size_t usage;
+    };
+
+    mutable Mutex m_mutex;
+    size_t m_max_bytes GUARDED_BY(m_mutex);
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+    //! Most recently used first
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::map<std::pair<uint256, bool>, std::list<Entry>::iterator> m_index GUARDED_BY(m_mutex);
+
+    std::shared_ptr<const void> Get(const std::pair<uint256, bool>& key);
+    void Add(const std::pair<uint256, bool>& key, std::shared_ptr<const void> data, size_t usage);
+    void Trim() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+};
+
+#endif // BITCOIN_BLOCKCACHE_H
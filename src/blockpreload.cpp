@@ -0,0 +1,105 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockpreload.h>
+
+#include <coins.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <validation.h>
+
+#include <set>
+
+void CBlockPreloader::Schedule(std::vector<Request> requests, const CCoinsView* coins)
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    m_coins = coins;
+    m_queue.clear();
+    std::set<const CBlockIndex*> wanted;
+    for (const Request& request : requests) {
+        wanted.insert(request.pindex);
+        if (request.pindex == m_busy) continue;
+        auto it = m_ready.find(request.pindex);
+        if (it != m_ready.end() && it->second.first == request.hash) continue;
+        m_queue.push_back(request);
+    }
+    for (auto it = m_ready.begin(); it != m_ready.end();) {
+        if (wanted.count(it->first)) {
+            ++it;
+        } else {
+            it = m_ready.erase(it);
+        }
+    }
+    m_busy_wanted = m_busy != nullptr && wanted.count(m_busy);
+    if (!m_queue.empty()) m_cond.notify_all();
+}
+
+std::shared_ptr<const CBlock> CBlockPreloader::Take(const CBlockIndex* pindex)
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    auto it = m_ready.find(pindex);
+    if (it == m_ready.end()) return nullptr;
+    std::shared_ptr<const CBlock> block;
+    // The index entry may have been freed and its address reused since the
+    // block was scheduled.
+    if (it->second.first == pindex->GetBlockHash()) block = std::move(it->second.second);
+    m_ready.erase(it);
+    return block;
+}
+
+void CBlockPreloader::Clear()
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    m_queue.clear();
+    m_ready.clear();
+    m_busy_wanted = false;
+    while (m_busy != nullptr) {
+        m_cond.wait(lock);
+    }
+    m_coins = nullptr;
+}
+
+void CBlockPreloader::Thread(const Consensus::Params& params)
+{
+    while (true) {
+        Request request;
+        const CCoinsView* coins;
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            if (m_busy != nullptr) {
+                m_busy = nullptr;
+                m_cond.notify_all();
+            }
+            while (m_queue.empty()) {
+                m_cond.wait(lock);
+            }
+            request = m_queue.front();
+            m_queue.pop_front();
+            m_busy = request.pindex;
+            m_busy_wanted = true;
+            coins = m_coins;
+        }
+
+        // Failures are left for ConnectTip to find and report.
+        auto block = std::make_shared<CBlock>();
+        if (!ReadBlockFromDisk(*block, request.pos, params) || block->GetHash() != request.hash) continue;
+        BlockValidationState state;
+        CheckBlock(*block, state, params);
+
+        if (coins != nullptr) {
+            std::set<uint256> block_txids;
+            for (const CTransactionRef& tx : block->vtx) {
+                if (!tx->IsCoinBase()) {
+                    for (const CTxIn& txin : tx->vin) {
+                        if (!block_txids.count(txin.prevout.hash)) coins->HaveCoin(txin.prevout);
+                    }
+                }
+                block_txids.insert(tx->GetHash());
+            }
+        }
+
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        if (m_busy_wanted) m_ready.emplace(request.pindex, std::make_pair(request.hash, std::move(block)));
+    }
+}
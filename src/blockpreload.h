@@ -0,0 +1,85 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKPRELOAD_H
+#define BITCOIN_BLOCKPRELOAD_H
+
+#include <flatfile.h>
+#include <uint256.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+class CBlock;
+class CBlockIndex;
+class CCoinsView;
+
+namespace Consensus {
+struct Params;
+} // namespace Consensus
+
+/**
+ * Prepares the blocks that are about to be connected while the block before
+ * them is being connected, so that cores do not sit idle between blocks
+ * during initial block download.
+ *
+ * For each scheduled block, a background thread reads the block from disk,
+ * checks that it hashes to what was expected, runs the context-free
+ * CheckBlock() on it, and looks up the coins it spends in the coins database,
+ * which warms the database without touching the coins cache.
+ *
+ * Nothing here decides whether a block is valid: blocks are still connected
+ * one at a time and in order, and ConnectTip() merely picks up the block read
+ * here instead of reading it itself. A block that fails CheckBlock() is
+ * handed over unchecked, so that ConnectBlock() reports the failure as usual.
+ * When a block turns out to be invalid, Clear() drops the work done for the
+ * blocks after it.
+ */
+class CBlockPreloader
+{
+public:
+    struct Request {
+        const CBlockIndex* pindex;
+        uint256 hash;
+        FlatFilePos pos;
+    };
+
+    /**
+     * Replace the blocks to preload with `requests`, in connection order.
+     * Blocks that are still requested keep their progress. `coins` is the
+     * view the spent coins are looked up in, or nullptr to skip that step; it
+     * must be safe to read from another thread, and stay valid until Clear()
+     * is called or Schedule() is called with a different view.
+     */
+    void Schedule(std::vector<Request> requests, const CCoinsView* coins);
+
+    /** Hand over the preloaded block for pindex, or nullptr if it is not ready. */
+    std::shared_ptr<const CBlock> Take(const CBlockIndex* pindex);
+
+    /** Drop all scheduled and preloaded blocks, and wait until none is being worked on. */
+    void Clear();
+
+    /** Preload scheduled blocks until the thread is interrupted. */
+    void Thread(const Consensus::Params& params);
+
+private:
+    boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+
+    //! Blocks to preload, in order.
+    std::deque<Request> m_queue;
+    //! Preloaded blocks, with the hash they were requested with.
+    std::map<const CBlockIndex*, std::pair<uint256, std::shared_ptr<const CBlock>>> m_ready;
+    //! The block being preloaded, if any, and whether it is still wanted.
+    const CBlockIndex* m_busy{nullptr};
+    bool m_busy_wanted{false};
+    const CCoinsView* m_coins{nullptr};
+};
+
+#endif // BITCOIN_BLOCKPRELOAD_H
@@ -0,0 +1,77 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockscan.h>
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <util/time.h>
+#include <validation.h>
+
+CBlockFileScanner::CBlockFileScanner(const CChainParams& chainparams, int num_files, int threads)
+    : m_chainparams(chainparams), m_num_files(num_files), m_window(threads)
+{
+    for (int i = 0; i < threads; ++i) {
+        m_threads.create_thread([this] { Thread(); });
+    }
+}
+
+CBlockFileScanner::~CBlockFileScanner()
+{
+    m_threads.interrupt_all();
+    m_threads.join_all();
+}
+
+CBlockFileScanner::File CBlockFileScanner::Take(int file)
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    assert(file == m_taken && file < m_num_files);
+    auto it = m_scanned.end();
+    while ((it = m_scanned.find(file)) == m_scanned.end()) {
+        m_cond.wait(lock);
+    }
+    File scanned = std::move(it->second);
+    m_scanned.erase(it);
+    ++m_taken;
+    m_cond.notify_all();
+    return scanned;
+}
+
+void CBlockFileScanner::Thread()
+{
+    while (true) {
+        int file;
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            while (m_next < m_num_files && m_next >= m_taken + m_window) {
+                m_cond.wait(lock);
+            }
+            if (m_next >= m_num_files) return;
+            file = m_next++;
+        }
+
+        const int64_t start = GetTimeMillis();
+        File scanned;
+        FlatFilePos pos(file, 0);
+        FILE* fileIn = OpenBlockFile(pos, true);
+        if (fileIn) {
+            scanned.opened = true;
+            ScanBlockFile(m_chainparams, fileIn, file, [&](std::shared_ptr<CBlock> block, const FlatFilePos& block_pos) {
+                boost::this_thread::interruption_point();
+                // Blocks that fail are left unchecked, so that AcceptBlock()
+                // reports the failure as usual.
+                BlockValidationState state;
+                CheckBlock(*block, state, m_chainparams.GetConsensus());
+                scanned.blocks.emplace_back(std::move(block), block_pos);
+                return true;
+            });
+        }
+        scanned.scan_time_ms = GetTimeMillis() - start;
+
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        m_scanned.emplace(file, std::move(scanned));
+        m_cond.notify_all();
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKSCAN_H
+#define BITCOIN_BLOCKSCAN_H
+
+#include <flatfile.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+class CBlock;
+class CChainParams;
+
+/**
+ * Scans the block files for -reindex on several threads.
+ *
+ * Finding the blocks in a block file, deserializing and hashing them and
+ * running the context-free CheckBlock() on them is independent of every
+ * other file, so each thread takes the next file that is not scanned yet.
+ * The results are handed over strictly in file order, so that the import
+ * thread can add the blocks to the index exactly as a sequential reindex
+ * would. To bound memory usage, files are not scanned further than one per
+ * thread ahead of the file being imported.
+ */
+class CBlockFileScanner
+{
+public:
+    struct File {
+        //! Whether the file could be opened
+        bool opened{false};
+        //! The blocks found, in file order, with their positions
+        std::vector<std::pair<std::shared_ptr<CBlock>, FlatFilePos>> blocks;
+        //! Time spent scanning the file
+        int64_t scan_time_ms{0};
+    };
+
+    /** Start `threads` threads scanning the block files numbered [0, num_files). */
+    CBlockFileScanner(const CChainParams& chainparams, int num_files, int threads);
+    /** Stop scanning, and wait for the threads to exit. */
+    ~CBlockFileScanner();
+
+    /**
+     * Wait for block file `file` to be scanned and hand it over. Files must
+     * be taken in order. On shutdown, the file may only be partly scanned.
+     */
+    File Take(int file);
+
+private:
+    const CChainParams& m_chainparams;
+    const int m_num_files;
+    const int m_window;
+
+    boost::mutex m_mutex;
+    boost::condition_variable m_cond;
+    //! Next file to hand to a scanning thread
+    int m_next{0};
+    //! Next file to be taken
+    int m_taken{0};
+    //! Scanned files that are not taken yet
+    std::map<int, File> m_scanned;
+
+    boost::thread_group m_threads;
+
+    void Thread();
+};
+
+#endif // BITCOIN_BLOCKSCAN_H
@@ -0,0 +1,126 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockwriter.h>
+
+#include <util/system.h>
+
+#include <functional>
+
+CBlockFileWriter::~CBlockFileWriter()
+{
+    Stop();
+}
+
+void CBlockFileWriter::Start(size_t max_pending_bytes)
+{
+    LOCK(m_mutex);
+    if (m_running) return;
+    m_max_pending_bytes = max_pending_bytes;
+    m_stop = false;
+    m_running = true;
+    m_thread = std::thread(&TraceThread<std::function<void()>>, "blockwrite", std::function<void()>(std::bind(&CBlockFileWriter::Thread, this)));
+}
+
+void CBlockFileWriter::Stop()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_cond.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+bool CBlockFileWriter::Write(FlatFileSeq seq, const FlatFilePos& pos, std::vector<unsigned char> data)
+{
+    const std::string path = seq.FileName(pos).string();
+    return Queue(Job{std::move(seq), pos, path, std::move(data), /* flush */ false, /* finalize */ false});
+}
+
+bool CBlockFileWriter::Flush(FlatFileSeq seq, const FlatFilePos& pos, bool finalize)
+{
+    const std::string path = seq.FileName(pos).string();
+    return Queue(Job{std::move(seq), pos, path, {}, /* flush */ true, finalize});
+}
+
+size_t CBlockFileWriter::Allocate(FlatFileSeq seq, const FlatFilePos& pos, size_t add_size, bool& out_of_space)
+{
+    // Allocating may write to the file where queued writes are still to go.
+    if (seq.NeedsAllocation(pos, add_size)) WaitForFile(seq, pos);
+    return seq.Allocate(pos, add_size, out_of_space);
+}
+
+void CBlockFileWriter::WaitForFile(const FlatFileSeq& seq, const FlatFilePos& pos)
+{
+    WAIT_LOCK(m_mutex, lock);
+    if (m_pending_files.empty()) return;
+    const std::string path = seq.FileName(pos).string();
+    while (m_pending_files.count(path)) m_cond.wait(lock);
+}
+
+bool CBlockFileWriter::Wait()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (!m_queue.empty()) m_cond.wait(lock);
+    return !m_failed;
+}
+
+bool CBlockFileWriter::Run(Job& job)
+{
+    if (job.flush) return job.seq.Flush(job.pos, job.finalize);
+
+    FILE* file = job.seq.Open(job.pos);
+    if (!file) {
+        return error("%s: failed to open %s", __func__, job.path);
+    }
+    if (fwrite(job.data.data(), 1, job.data.size(), file) != job.data.size()) {
+        fclose(file);
+        return error("%s: failed to write to %s", __func__, job.path);
+    }
+    if (fclose(file) != 0) {
+        return error("%s: failed to close %s", __func__, job.path);
+    }
+    return true;
+}
+
+bool CBlockFileWriter::Queue(Job job)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        if (m_running) {
+            if (m_failed) return false;
+            while (m_pending_bytes != 0 && m_pending_bytes + job.data.size() > m_max_pending_bytes) m_cond.wait(lock);
+            m_pending_bytes += job.data.size();
+            ++m_pending_files[job.path];
+            m_queue.push_back(std::move(job));
+            m_cond.notify_all();
+            return true;
+        }
+    }
+    return Run(job);
+}
+
+void CBlockFileWriter::Thread()
+{
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        while (!m_stop && m_queue.empty()) m_cond.wait(lock);
+        if (m_queue.empty()) {
+            // Jobs queued from now on run in the calling thread.
+            m_running = false;
+            return;
+        }
+
+        // Only this thread removes jobs, so the reference stays valid.
+        Job& job = m_queue.front();
+        bool ok;
+        {
+            REVERSE_LOCK(lock);
+            ok = Run(job);
+        }
+        if (!ok) m_failed = true;
+        m_pending_bytes -= job.data.size();
+        if (--m_pending_files[job.path] == 0) m_pending_files.erase(job.path);
+        m_queue.pop_front();
+        m_cond.notify_all();
+    }
+}
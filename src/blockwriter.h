@@ -0,0 +1,90 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKWRITER_H
+#define BITCOIN_BLOCKWRITER_H
+
+#include <flatfile.h>
+#include <sync.h>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Writes block and undo data to their files on a background thread, so that
+ * block validation does not wait for the disk, in particular for the fsync
+ * done when leaving a block file.
+ *
+ * Jobs run one at a time and in the order they were queued, so a flush
+ * commits every write queued for the file before it. Reading a file, or
+ * allocating more space in it, must first wait for the jobs queued for that
+ * file (WaitForFile). A failed job is logged and makes Wait() return false;
+ * callers must Wait() before recording anything that refers to the data
+ * written, such as the block index, so that durability is ordered as if the
+ * writes were made synchronously.
+ *
+ * Until Start() is called, and after Stop(), jobs run in the calling thread.
+ */
+class CBlockFileWriter
+{
+public:
+    ~CBlockFileWriter();
+
+    /**
+     * Start the background thread. Queuing a write blocks while the data
+     * waiting to be written exceeds max_pending_bytes.
+     */
+    void Start(size_t max_pending_bytes);
+
+    /** Complete the queued jobs and stop the background thread. */
+    void Stop();
+
+    /** Write data at pos. Returns false if this or an earlier job failed. */
+    bool Write(FlatFileSeq seq, const FlatFilePos& pos, std::vector<unsigned char> data);
+
+    /** FlatFileSeq::Flush() after the writes queued so far. Returns false if this or an earlier job failed. */
+    bool Flush(FlatFileSeq seq, const FlatFilePos& pos, bool finalize = false);
+
+    /** FlatFileSeq::Allocate(), waiting for the file first if a new chunk is needed. */
+    size_t Allocate(FlatFileSeq seq, const FlatFilePos& pos, size_t add_size, bool& out_of_space);
+
+    /** Wait until the jobs queued for the file at pos are done. */
+    void WaitForFile(const FlatFileSeq& seq, const FlatFilePos& pos);
+
+    /** Wait until all queued jobs are done. Returns false if any job failed. */
+    bool Wait();
+
+private:
+    struct Job {
+        FlatFileSeq seq;
+        FlatFilePos pos;
+        std::string path;
+        //! Data to write, or nothing for a flush.
+        std::vector<unsigned char> data;
+        bool flush;
+        bool finalize;
+    };
+
+    static bool Run(Job& job);
+    bool Queue(Job job);
+    void Thread();
+
+    Mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<Job> m_queue GUARDED_BY(m_mutex);
+    //! Number of queued or running jobs, by file name.
+    std::map<std::string, int> m_pending_files GUARDED_BY(m_mutex);
+    size_t m_pending_bytes GUARDED_BY(m_mutex){0};
+    size_t m_max_pending_bytes GUARDED_BY(m_mutex){0};
+    bool m_running GUARDED_BY(m_mutex){false};
+    bool m_failed GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::thread m_thread;
+};
+
+#endif // BITCOIN_BLOCKWRITER_H
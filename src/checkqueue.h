@@ -6,14 +6,28 @@
 #define BITCOIN_CHECKQUEUE_H
 
 #include <sync.h>
+#include <util/memory.h>
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 
-template <typename T>
+/**
+ * Default batch type for CCheckQueue: every check does all of its work when run.
+ */
+struct CCheckQueueNoBatch
+{
+    template <typename T>
+    bool Run(T& check) { return check(); }
+    bool Verify() { return true; }
+    void Clear() {}
+};
+
+template <typename T, typename B>
 class CCheckQueueControl;
 
 /**
@@ -25,11 +39,32 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Each batch passed to Add() becomes a chunk on a list that only grows
+  * until the master is done. Workers walk the list without taking a lock,
+  * claiming runs of checks from a chunk by advancing its atomic cursor, and
+  * move on to the next chunk once theirs has been claimed in full. The mutex
+  * is only taken to append chunks and to put idle workers to sleep, so the
+  * number of workers is not limited by contention on it.
+  *
+  * Each worker runs its checks through its own instance of B, which lets
+  * checks defer part of their work (see CCheckQueueNoBatch for the
+  * interface). The deferred work is verified at once, after each run of
+  * checks the worker claims.
   */
-template <typename T>
+template <typename T, typename B = CCheckQueueNoBatch>
 class CCheckQueue
 {
 private:
+    //! The checks of one Add() call.
+    struct Chunk {
+        std::vector<T> checks;
+        //! Index of the first check not claimed by a worker yet.
+        std::atomic<size_t> next{0};
+        //! The chunk added after this one, if any.
+        std::atomic<Chunk*> link{nullptr};
+    };
+
     //! Mutex to protect the inner state
     boost::mutex mutex;
 
@@ -39,86 +74,116 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
+    //! The chunks added since the master last returned, in order. Their
+    //! checks are only freed once no worker is walking them.
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+
+    //! First chunk of the list workers walk, or nullptr if there is none.
+    Chunk* m_head{nullptr};
 
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
+    //! Incremented whenever the master drops the chunks, so that workers forget their position.
+    uint64_t m_round{0};
+
+    //! The number of workers (including the master) walking the chunks.
+    int m_active{0};
 
     //! The total number of workers (including the master).
-    int nTotal;
+    std::atomic<int> nTotal{0};
 
     //! The temporary evaluation result.
-    bool fAllOk;
+    std::atomic<bool> fAllOk{true};
 
     /**
      * Number of verifications that haven't completed yet.
-     * This includes elements that are no longer queued, but still in the
-     * worker's own batches.
+     * This includes elements that are no longer queued, but still being
+     * run by a worker.
      */
-    unsigned int nTodo;
+    std::atomic<size_t> nTodo{0};
 
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
-    /** Internal function that does bulk of the verification work. */
-    bool Loop(bool fMaster = false)
+    /**
+     * Claim and run checks, starting at chunk, until every check up to the
+     * end of the list has been claimed. Returns the last chunk visited.
+     */
+    Chunk* Work(Chunk* chunk, B& batch)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
-        std::vector<T> vChecks;
-        vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
-        do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
-                }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if (fMaster && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
-                }
+        while (true) {
+            const size_t size = chunk->checks.size();
+            size_t begin = chunk->next.load(std::memory_order_relaxed);
+            if (begin < size) {
                 // Decide how many work units to process now.
                 // * Do not try to do everything at once, but aim for increasingly smaller batches so
                 //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
                 // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
+                const size_t now = std::max<size_t>(1, std::min<size_t>(nBatchSize, (size - begin) / (nTotal.load(std::memory_order_relaxed) + 1)));
+                begin = chunk->next.fetch_add(now, std::memory_order_relaxed);
+                if (begin < size) {
+                    const size_t end = std::min(begin + now, size);
+                    // Check whether we need to do work at all
+                    bool fOk = fAllOk.load(std::memory_order_relaxed);
+                    for (size_t i = begin; fOk && i < end; ++i) {
+                        fOk = batch.Run(chunk->checks[i]);
+                    }
+                    if (fOk) {
+                        fOk = batch.Verify();
+                    } else {
+                        batch.Clear();
+                    }
+                    if (!fOk) fAllOk.store(false, std::memory_order_relaxed);
+                    nTodo.fetch_sub(end - begin, std::memory_order_acq_rel);
+                    continue;
                 }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
             }
-            // execute work
-            for (T& check : vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
+            Chunk* next = chunk->link.load(std::memory_order_acquire);
+            if (next == nullptr) return chunk;
+            chunk = next;
+        }
+    }
+
+    /** Internal function that does bulk of the verification work. */
+    bool Loop(bool fMaster = false)
+    {
+        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
+        B batch;
+        Chunk* last = nullptr;
+        uint64_t round = 0;
+        boost::unique_lock<boost::mutex> lock(mutex);
+        nTotal++;
+        do {
+            if (round != m_round) {
+                last = nullptr;
+                round = m_round;
+            }
+            Chunk* next = last != nullptr ? last->link.load(std::memory_order_relaxed) : m_head;
+            if (next != nullptr) {
+                m_active++;
+                lock.unlock();
+                last = Work(next, batch);
+                lock.lock();
+                m_active--;
+                if (m_active == 0 && nTodo.load(std::memory_order_acquire) == 0 && !fMaster)
+                    // We were the last one running checks; inform the master it can exit and return the result
+                    condMaster.notify_one();
+                continue;
+            }
+            if (fMaster && m_active == 0 && nTodo.load(std::memory_order_acquire) == 0) {
+                nTotal--;
+                bool fRet = fAllOk.load(std::memory_order_relaxed);
+                // reset the status for new work later
+                fAllOk.store(true, std::memory_order_relaxed);
+                std::vector<std::unique_ptr<Chunk>> chunks;
+                chunks.swap(m_chunks);
+                m_head = nullptr;
+                m_round++;
+                // Free the checks without holding the lock
+                lock.unlock();
+                chunks.clear();
+                // return the current status
+                return fRet;
+            }
+            cond.wait(lock); // wait
         } while (true);
     }
 
@@ -127,7 +192,7 @@ public:
     boost::mutex ControlMutex;
 
     //! Create a new check queue
-    explicit CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), nBatchSize(nBatchSizeIn) {}
+    explicit CCheckQueue(unsigned int nBatchSizeIn) : nBatchSize(nBatchSizeIn) {}
 
     //! Worker thread
     void Thread()
@@ -141,19 +206,29 @@ public:
         return Loop(true);
     }
 
-    //! Add a batch of checks to the queue
+    //! Add a batch of checks to the queue. The checks are moved out of vChecks.
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        for (T& check : vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
+        if (vChecks.empty()) return;
+        const size_t size = vChecks.size();
+        auto chunk = MakeUnique<Chunk>();
+        chunk->checks.swap(vChecks);
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            nTodo.fetch_add(size, std::memory_order_relaxed);
+            if (m_chunks.empty()) {
+                m_head = chunk.get();
+            } else {
+                m_chunks.back()->link.store(chunk.get(), std::memory_order_release);
+            }
+            m_chunks.push_back(std::move(chunk));
         }
-        nTodo += vChecks.size();
-        if (vChecks.size() == 1)
-            condWorker.notify_one();
-        else if (vChecks.size() > 1)
+        // Wake no more workers than there are checks to claim
+        if (size >= (size_t)nTotal.load(std::memory_order_relaxed)) {
             condWorker.notify_all();
+        } else {
+            for (size_t i = 0; i < size; ++i) condWorker.notify_one();
+        }
     }
 
     ~CCheckQueue()
@@ -166,18 +241,18 @@ public:
  * RAII-style controller object for a CCheckQueue that guarantees the passed
  * queue is finished before continuing.
  */
-template <typename T>
+template <typename T, typename B = CCheckQueueNoBatch>
 class CCheckQueueControl
 {
 private:
-    CCheckQueue<T> * const pqueue;
+    CCheckQueue<T, B> * const pqueue;
     bool fDone;
 
 public:
     CCheckQueueControl() = delete;
     CCheckQueueControl(const CCheckQueueControl&) = delete;
     CCheckQueueControl& operator=(const CCheckQueueControl&) = delete;
-    explicit CCheckQueueControl(CCheckQueue<T> * const pqueueIn) : pqueue(pqueueIn), fDone(false)
+    explicit CCheckQueueControl(CCheckQueue<T, B> * const pqueueIn) : pqueue(pqueueIn), fDone(false)
     {
         // passed queue is supposed to be unused, or nullptr
         if (pqueue != nullptr) {
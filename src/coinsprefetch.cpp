@@ -0,0 +1,58 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <coinsprefetch.h>
+
+#include <checkqueue.h>
+#include <primitives/block.h>
+#include <uint256.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+bool CCoinsPrefetchCheck::operator()()
+{
+    *m_found = m_view->GetCoin(m_outpoint, *m_coin);
+    // A missing coin is not an error here; ConnectBlock will report it.
+    return true;
+}
+
+size_t PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, const CCoinsView& base, CCheckQueue<CCoinsPrefetchCheck>& queue)
+{
+    // Outputs created within the block are never in the backing view.
+    std::set<uint256> block_txids;
+
+    std::vector<COutPoint> outpoints;
+    for (const auto& tx : block.vtx) {
+        if (!tx->IsCoinBase()) {
+            for (const CTxIn& txin : tx->vin) {
+                if (block_txids.count(txin.prevout.hash) || cache.HaveCoinInCache(txin.prevout)) continue;
+                outpoints.push_back(txin.prevout);
+            }
+        }
+        block_txids.insert(tx->GetHash());
+    }
+    if (outpoints.empty()) return 0;
+
+    std::vector<Coin> coins(outpoints.size());
+    // Not std::vector<bool>: each worker needs its own addressable slot.
+    std::unique_ptr<bool[]> found(new bool[outpoints.size()]());
+    {
+        CCheckQueueControl<CCoinsPrefetchCheck> control(&queue);
+        std::vector<CCoinsPrefetchCheck> checks;
+        checks.reserve(outpoints.size());
+        for (size_t i = 0; i < outpoints.size(); ++i) {
+            checks.emplace_back(base, outpoints[i], coins[i], found[i]);
+        }
+        control.Add(checks);
+        control.Wait();
+    }
+
+    size_t added = 0;
+    for (size_t i = 0; i < outpoints.size(); ++i) {
+        if (found[i] && cache.EmplaceCoinFromBase(outpoints[i], std::move(coins[i]))) ++added;
+    }
+    return added;
+}
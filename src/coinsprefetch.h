@@ -0,0 +1,63 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COINSPREFETCH_H
+#define BITCOIN_COINSPREFETCH_H
+
+#include <checkqueue.h>
+#include <coins.h>
+#include <primitives/transaction.h>
+
+#include <stddef.h>
+
+class CBlock;
+
+/**
+ * Closure representing a single prevout lookup against the view backing the
+ * coins cache. These are run by the workers of a CCheckQueue; the result is
+ * written to a slot owned by the caller, which merges it into the cache on
+ * its own thread once the queue is drained.
+ */
+class CCoinsPrefetchCheck
+{
+private:
+    const CCoinsView* m_view{nullptr};
+    COutPoint m_outpoint;
+    Coin* m_coin{nullptr};
+    bool* m_found{nullptr};
+
+public:
+    CCoinsPrefetchCheck() {}
+    CCoinsPrefetchCheck(const CCoinsView& view, const COutPoint& outpoint, Coin& coin, bool& found) :
+        m_view(&view), m_outpoint(outpoint), m_coin(&coin), m_found(&found) {}
+
+    bool operator()();
+
+    void swap(CCoinsPrefetchCheck& check)
+    {
+        std::swap(m_view, check.m_view);
+        std::swap(m_outpoint, check.m_outpoint);
+        std::swap(m_coin, check.m_coin);
+        std::swap(m_found, check.m_found);
+    }
+};
+
+/**
+ * Warm a coins cache with the coins spent by a block, before the block is
+ * connected.
+ *
+ * Every prevout that is neither present in `cache` nor created earlier in the
+ * same block is looked up in `base` by the workers of `queue`. Found coins are
+ * then added to `cache` as clean entries on the calling thread, exactly as if
+ * they had been pulled in one at a time by CCoinsViewCache::FetchCoin.
+ *
+ * `base` must be the view directly backing `cache`, and must be safe to read
+ * from several threads at once (as CCoinsViewDB is). It must not be modified
+ * while this function runs.
+ *
+ * @returns the number of coins added to `cache`.
+ */
+size_t PrefetchBlockInputs(const CBlock& block, CCoinsViewCache& cache, const CCoinsView& base, CCheckQueue<CCoinsPrefetchCheck>& queue);
+
+#endif // BITCOIN_COINSPREFETCH_H
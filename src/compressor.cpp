@@ -5,6 +5,7 @@
 
 #include <compressor.h>
 
+#include <amount.h>
 #include <pubkey.h>
 #include <script/standard.h>
 
@@ -190,3 +191,15 @@ uint64_t DecompressAmount(uint64_t x)
     }
     return n;
 }
+
+bool IsBlockCompressible(const CBlock& block)
+{
+    for (const CTransactionRef& tx : block.vtx) {
+        for (const CTxOut& txout : tx->vout) {
+            // AmountCompression is only defined for valid amounts, and
+            // ScriptCompression truncates overly long scripts.
+            if (!MoneyRange(txout.nValue) || txout.scriptPubKey.size() > MAX_SCRIPT_SIZE) return false;
+        }
+    }
+    return true;
+}
@@ -6,6 +6,7 @@
 #ifndef BITCOIN_COMPRESSOR_H
 #define BITCOIN_COMPRESSOR_H
 
+#include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <serialize.h>
@@ -103,4 +104,78 @@ struct TxOutCompression
     FORMATTER_METHODS(CTxOut, obj) { READWRITE(Using<AmountCompression>(obj.nValue), Using<ScriptCompression>(obj.scriptPubKey)); }
 };
 
+/** Whether BlockCompression can store every output of the block without loss. */
+bool IsBlockCompressible(const CBlock& block);
+
+/**
+ * Compact serializer for transactions in blocks stored on disk.
+ *
+ * Outputs use TxOutCompression, and the other integers are stored as VARINTs,
+ * arranged so that their usual values take a single byte: input indexes are
+ * offset by one so that the coinbase's 0xffffffff becomes 0, and sequence
+ * numbers are inverted so that 0xffffffff and the values just below it are
+ * small. The witness is stored after the outputs when present, as in the
+ * usual serialization.
+ */
+struct DiskTransactionCompression
+{
+    template<typename Stream>
+    void Ser(Stream& s, const CTransactionRef& tx)
+    {
+        s << VARINT(uint32_t(tx->nVersion));
+        const uint8_t flags = tx->HasWitness() ? 1 : 0;
+        s << flags;
+        WriteCompactSize(s, tx->vin.size());
+        for (const CTxIn& txin : tx->vin) {
+            s << txin.prevout.hash << VARINT(uint32_t(txin.prevout.n + 1)) << txin.scriptSig << VARINT(uint32_t(~txin.nSequence));
+        }
+        s << Using<VectorFormatter<TxOutCompression>>(tx->vout);
+        if (flags & 1) {
+            for (const CTxIn& txin : tx->vin) {
+                s << txin.scriptWitness.stack;
+            }
+        }
+        s << VARINT(tx->nLockTime);
+    }
+
+    template<typename Stream>
+    void Unser(Stream& s, CTransactionRef& tx)
+    {
+        CMutableTransaction mtx;
+        uint32_t version;
+        s >> VARINT(version);
+        mtx.nVersion = int32_t(version);
+        uint8_t flags;
+        s >> flags;
+        if (flags & ~1) {
+            throw std::ios_base::failure("Unknown transaction compression flags");
+        }
+        mtx.vin.resize(ReadCompactSize(s));
+        for (CTxIn& txin : mtx.vin) {
+            uint32_t n, sequence;
+            s >> txin.prevout.hash >> VARINT(n) >> txin.scriptSig >> VARINT(sequence);
+            txin.prevout.n = n - 1;
+            txin.nSequence = ~sequence;
+        }
+        s >> Using<VectorFormatter<TxOutCompression>>(mtx.vout);
+        if (flags & 1) {
+            for (CTxIn& txin : mtx.vin) {
+                s >> txin.scriptWitness.stack;
+            }
+        }
+        s >> VARINT(mtx.nLockTime);
+        tx = MakeTransactionRef(std::move(mtx));
+    }
+};
+
+/**
+ * Compact serializer for blocks stored on disk (see -compressblocks). The
+ * header is stored as usual, so it can be read without decompressing the
+ * transactions. Only for blocks for which IsBlockCompressible() holds.
+ */
+struct BlockCompression
+{
+    FORMATTER_METHODS(CBlock, obj) { READWRITEAS(CBlockHeader, obj); READWRITE(Using<VectorFormatter<DiskTransactionCompression>>(obj.vtx)); }
+};
+
 #endif // BITCOIN_COMPRESSOR_H
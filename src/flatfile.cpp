@@ -10,6 +10,13 @@
 #include <tinyformat.h>
 #include <util/system.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 FlatFileSeq::FlatFileSeq(fs::path dir, const char* prefix, size_t chunk_size) :
     m_dir(std::move(dir)),
     m_prefix(prefix),
@@ -52,13 +59,19 @@ FILE* FlatFileSeq::Open(const FlatFilePos& pos, bool read_only)
     return file;
 }
 
+bool FlatFileSeq::NeedsAllocation(const FlatFilePos& pos, size_t add_size) const
+{
+    unsigned int n_old_chunks = (pos.nPos + m_chunk_size - 1) / m_chunk_size;
+    unsigned int n_new_chunks = (pos.nPos + add_size + m_chunk_size - 1) / m_chunk_size;
+    return n_new_chunks > n_old_chunks;
+}
+
 size_t FlatFileSeq::Allocate(const FlatFilePos& pos, size_t add_size, bool& out_of_space)
 {
     out_of_space = false;
 
-    unsigned int n_old_chunks = (pos.nPos + m_chunk_size - 1) / m_chunk_size;
-    unsigned int n_new_chunks = (pos.nPos + add_size + m_chunk_size - 1) / m_chunk_size;
-    if (n_new_chunks > n_old_chunks) {
+    if (NeedsAllocation(pos, add_size)) {
+        unsigned int n_new_chunks = (pos.nPos + add_size + m_chunk_size - 1) / m_chunk_size;
         size_t old_size = pos.nPos;
         size_t new_size = n_new_chunks * m_chunk_size;
         size_t inc_size = new_size - old_size;
@@ -97,3 +110,72 @@ bool FlatFileSeq::Flush(const FlatFilePos& pos, bool finalize)
     fclose(file);
     return true;
 }
+
+#ifndef WIN32
+std::shared_ptr<const MappedFlatFile> MappedFlatFile::Open(const fs::path& path)
+{
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+    if (data == MAP_FAILED) {
+        LogPrintf("Unable to map file %s\n", path.string());
+        return nullptr;
+    }
+    return std::shared_ptr<const MappedFlatFile>(new MappedFlatFile(static_cast<const unsigned char*>(data), st.st_size));
+}
+
+MappedFlatFile::~MappedFlatFile()
+{
+    munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+#else
+std::shared_ptr<const MappedFlatFile> MappedFlatFile::Open(const fs::path& path)
+{
+    return nullptr;
+}
+
+MappedFlatFile::~MappedFlatFile() {}
+#endif
+
+std::shared_ptr<const MappedFlatFile> FlatFileMapCache::Get(const FlatFileSeq& seq, const FlatFilePos& pos, size_t length)
+{
+    if (m_max_files == 0 || pos.IsNull()) {
+        return nullptr;
+    }
+    LOCK(m_mutex);
+    auto it = m_files.begin();
+    while (it != m_files.end() && it->first != pos.nFile) {
+        ++it;
+    }
+    if (it != m_files.end()) {
+        if (it->second->Data().size() >= size_t{pos.nPos} + length) {
+            m_files.splice(m_files.begin(), m_files, it);
+            return it->second;
+        }
+        // The file has grown since it was mapped.
+        m_files.erase(it);
+    }
+    std::shared_ptr<const MappedFlatFile> file = MappedFlatFile::Open(seq.FileName(pos));
+    if (!file || file->Data().size() < size_t{pos.nPos} + length) {
+        return nullptr;
+    }
+    m_files.emplace_front(pos.nFile, file);
+    if (m_files.size() > m_max_files) {
+        m_files.pop_back();
+    }
+    return file;
+}
+
+void FlatFileMapCache::Drop(int file)
+{
+    LOCK(m_mutex);
+    m_files.remove_if([file](const std::pair<int, std::shared_ptr<const MappedFlatFile>>& entry) { return entry.first == file; });
+}
@@ -6,10 +6,14 @@
 #ifndef BITCOIN_FLATFILE_H
 #define BITCOIN_FLATFILE_H
 
+#include <list>
+#include <memory>
 #include <string>
 
 #include <fs.h>
 #include <serialize.h>
+#include <span.h>
+#include <sync.h>
 
 struct FlatFilePos
 {
@@ -77,6 +81,9 @@ public:
      */
     size_t Allocate(const FlatFilePos& pos, size_t add_size, bool& out_of_space);
 
+    /** Whether Allocate(pos, add_size, ...) would allocate a new chunk. */
+    bool NeedsAllocation(const FlatFilePos& pos, size_t add_size) const;
+
     /**
      * Commit a file to disk, and optionally truncate off extra pre-allocated bytes if final.
      *
@@ -87,4 +94,55 @@ public:
     bool Flush(const FlatFilePos& pos, bool finalize = false);
 };
 
+/** A read-only memory mapping of a whole file, as it was when mapped. */
+class MappedFlatFile
+{
+private:
+    const unsigned char* m_data;
+    size_t m_size;
+
+    MappedFlatFile(const unsigned char* data, size_t size) : m_data(data), m_size(size) {}
+
+public:
+    MappedFlatFile(const MappedFlatFile&) = delete;
+    MappedFlatFile& operator=(const MappedFlatFile&) = delete;
+    ~MappedFlatFile();
+
+    /** Map the file at path, or return nullptr if it cannot be mapped. */
+    static std::shared_ptr<const MappedFlatFile> Open(const fs::path& path);
+
+    Span<const unsigned char> Data() const { return {m_data, m_size}; }
+};
+
+/**
+ * Keeps read-only mappings of the most recently used files of a FlatFileSeq,
+ * up to a fixed number of files. Mappings that were handed out remain valid
+ * after they are dropped from the cache.
+ *
+ * Only ranges of a file that will not be truncated away may be read through a
+ * mapping: accessing a mapped page past the end of the file raises SIGBUS.
+ */
+class FlatFileMapCache
+{
+private:
+    Mutex m_mutex;
+    const size_t m_max_files;
+    //! Mappings by file number, most recently used first.
+    std::list<std::pair<int, std::shared_ptr<const MappedFlatFile>>> m_files GUARDED_BY(m_mutex);
+
+public:
+    //! A cache that holds at most max_files mappings. With 0, nothing is ever mapped.
+    explicit FlatFileMapCache(size_t max_files) : m_max_files(max_files) {}
+
+    /**
+     * Get a mapping of the file holding pos that covers at least length bytes
+     * from pos. Returns nullptr if mapping is disabled or the file cannot be
+     * mapped or is too short.
+     */
+    std::shared_ptr<const MappedFlatFile> Get(const FlatFileSeq& seq, const FlatFilePos& pos, size_t length);
+
+    /** Drop the mapping of a file, if any, for example because it was deleted. */
+    void Drop(int file);
+};
+
 #endif // BITCOIN_FLATFILE_H
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <compressor.h>
 #include <index/disktxpos.h>
 #include <index/txindex.h>
 #include <node/ui_interface.h>
@@ -235,17 +236,39 @@ bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRe
         return false;
     }
 
-    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    // Start at the size field of the index header, to tell whether the block is compressed.
+    FlatFilePos hpos = postx;
+    if (hpos.nPos < 4) {
+        return error("%s: No index header", __func__);
+    }
+    hpos.nPos -= 4;
+    CAutoFile file(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
     if (file.IsNull()) {
         return error("%s: OpenBlockFile failed", __func__);
     }
     CBlockHeader header;
     try {
-        file >> header;
-        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
-            return error("%s: fseek(...) failed", __func__);
+        unsigned int size;
+        file >> size;
+        if (size & BLOCK_RECORD_COMPRESSED) {
+            // The offset of the transaction is not known in this format.
+            CBlock block;
+            file >> Using<BlockCompression>(block);
+            header = block.GetBlockHeader();
+            tx = nullptr;
+            for (const CTransactionRef& block_tx : block.vtx) {
+                if (block_tx->GetHash() == tx_hash) tx = block_tx;
+            }
+            if (!tx) {
+                return error("%s: transaction not found in block", __func__);
+            }
+        } else {
+            file >> header;
+            if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
+                return error("%s: fseek(...) failed", __func__);
+            }
+            file >> tx;
         }
-        file >> tx;
     } catch (const std::exception& e) {
         return error("%s: Deserialize or I/O error - %s", __func__, e.what());
     }
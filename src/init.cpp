@@ -12,7 +12,10 @@
 #include <addrman.h>
 #include <amount.h>
 #include <banman.h>
+#include <blockcache.h>
 #include <blockfilter.h>
+#include <blockscan.h>
+#include <blockwriter.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <clientversion.h>
@@ -294,6 +297,8 @@ void Shutdown(NodeContext& node)
         }
         pblocktree.reset();
     }
+    // Everything written was waited for by the flush above.
+    g_block_writer.Stop();
     for (const auto& client : node.chain_clients) {
         client->stop();
     }
@@ -405,17 +410,22 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-asyncblockwrites", strprintf("Write blocks and undo data to disk in a background thread, letting block validation continue meanwhile (default: %u)", DEFAULT_ASYNC_BLOCK_WRITES), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
     argsman.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
+    argsman.AddArg("-blockreadcache=<n>", strprintf("Memory in MiB to use for recently read blocks served to peers and RPC clients (0 to disable, default: %u)", DEFAULT_BLOCK_READ_CACHE_SIZE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Automatic broadcast and rebroadcast of any transactions from peers is disabled, unless the peer has the 'forcerelay' permission. RPC transactions are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-compressblocks", strprintf("Store new blocks in a compact format, which older versions cannot read (default: %u)", DEFAULT_COMPRESS_BLOCKS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-conf=<file>", strprintf("Specify path to read-only configuration file. Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-confrw=<file>", strprintf("Specify read/write configuration file. Relative paths will be prefixed by the network-specific datadir location. (default: %s)", BITCOIN_RW_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-convertblocks", "Rewrite all stored blocks in the format selected by -compressblocks on startup, before connecting to peers. Rebuilds -txindex", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-corepolicy", strprintf("Use Bitcoin Core policy defaults (default: %s)", DEFAULT_COREPOLICY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbasyncflush", strprintf("Write the chainstate to disk in a background thread, letting block validation continue meanwhile (default: %u)", DEFAULT_DB_ASYNC_FLUSH), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d). In addition, unused mempool memory is shared for this cache (see -maxmempool).", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-debuglogfile=<file>", strprintf("Specify location of debug log file. Relative paths will be prefixed by a net-specific datadir location. (-nodebuglogfile to disable; default: %s)", DEFAULT_DEBUGLOGFILE), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-feefilter", strprintf("Tell other nodes to filter invs to us by our mempool min fee (default: %u)", DEFAULT_FEEFILTER), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
@@ -426,15 +436,18 @@ void SetupServerArgs(NodeContext& node)
     argsman.AddArg("-maxorphantx=<n>", strprintf("Keep at most <n> unconnectable transactions in memory (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s, signet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex(), signetChainParams->GetConsensus().nMinimumChainWork.GetHex()), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
-    argsman.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
-        -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%d or more, 0 = auto, <0 = leave that many cores free, default: %d)",
+        -GetNumCores(), DEFAULT_SCRIPTCHECK_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-persistmempool", strprintf("Whether to save the mempool on shutdown and load on restart (default: %u)", DEFAULT_PERSIST_MEMPOOL), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-pid=<file>", strprintf("Specify pid file. Relative paths will be prefixed by a net-specific datadir location. (default: %s)", BITCOIN_PID_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-prefetchinputs", strprintf("Look up the coins spent by a block in parallel before connecting it, using as many threads as -par (default: %u)", DEFAULT_PREFETCH_INPUTS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-preloadblocks=<n>", strprintf("During initial block download, read and check up to <n> blocks ahead of the one being connected on a dedicated thread (0 to disable, default: %u)", DEFAULT_PRELOAD_BLOCKS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks, and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex and -rescan. "
             "Warning: Reverting this setting requires re-downloading the entire blockchain. "
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >=%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk. Setting this to auto automatically reindexes the block database if it is corrupted.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks. When in pruning mode or if blocks on disk might be corrupted, use full -reindex instead.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-reindexthreads=<n>", strprintf("Number of threads scanning block files during -reindex, each holding one block file in memory (0 = one per core up to %d, 1 = scan on the import thread, default: %d)", MAX_REINDEX_THREADS, DEFAULT_REINDEX_THREADS), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-settings=<file>", strprintf("Specify path to dynamic settings data file. Can be disabled with -nosettings. File is written at runtime and not meant to be edited by users (use %s instead for custom settings). Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME, BITCOIN_SETTINGS_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-softwareexpiry", strprintf("Stop working after this POSIX timestamp (default: %s)", DEFAULT_SOFTWARE_EXPIRY), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
 #if HAVE_SYSTEM
@@ -737,22 +750,43 @@ static void ThreadImport(ChainstateManager& chainman, std::vector<fs::path> vImp
 
     // -reindex
     if (fReindex) {
-        int nFile = 0;
-        while (true) {
-            FlatFilePos pos(nFile, 0);
-            if (!fs::exists(GetBlockPosFilename(pos)))
-                break; // No block files left to reindex
-            FILE *file = OpenBlockFile(pos, true);
-            if (!file)
-                break; // This error is logged in OpenBlockFile
-            LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            LoadExternalBlockFile(chainparams, file, &pos);
+        int num_files = 0;
+        while (fs::exists(GetBlockPosFilename(FlatFilePos(num_files, 0)))) {
+            num_files++;
+        }
+        int threads = args.GetArg("-reindexthreads", DEFAULT_REINDEX_THREADS);
+        if (threads <= 0) threads = std::min(GetNumCores(), MAX_REINDEX_THREADS);
+        threads = std::max(1, threads);
+        // With several threads, block files are scanned ahead of the one being imported.
+        std::unique_ptr<CBlockFileScanner> scanner;
+        if (threads > 1) {
+            LogPrintf("Reindexing %d block files, scanning them with %d threads\n", num_files, threads);
+            scanner = MakeUnique<CBlockFileScanner>(chainparams, num_files, threads);
+        }
+        for (int nFile = 0; nFile < num_files; nFile++) {
+            LogPrintf("Reindexing block file blk%05u.dat (%d/%d)...\n", (unsigned int)nFile, nFile + 1, num_files);
+            uiInterface.ShowProgress(_("Reindexing blocks...").translated, nFile * 100 / num_files, false);
+            if (scanner) {
+                const CBlockFileScanner::File scanned = scanner->Take(nFile);
+                if (!scanned.opened)
+                    break; // This error is logged in OpenBlockFile
+                LogPrintf("Scanned block file blk%05u.dat in %dms\n", (unsigned int)nFile, scanned.scan_time_ms);
+                LoadScannedBlocks(chainparams, scanned.blocks);
+            } else {
+                FlatFilePos pos(nFile, 0);
+                FILE *file = OpenBlockFile(pos, true);
+                if (!file)
+                    break; // This error is logged in OpenBlockFile
+                LoadExternalBlockFile(chainparams, file, &pos);
+            }
             if (ShutdownRequested()) {
+                uiInterface.ShowProgress("", 100, false);
                 LogPrintf("Shutdown requested. Exit %s\n", __func__);
                 return;
             }
-            nFile++;
         }
+        scanner.reset();
+        uiInterface.ShowProgress("", 100, false);
         pblocktree->WriteReindexing(false);
         fReindex = false;
         LogPrintf("Reindexing finished\n");
@@ -1443,9 +1477,6 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
     // Subtract 1 because the main thread counts towards the par threads
     script_threads = std::max(script_threads - 1, 0);
 
-    // Number of script-checking threads <= MAX_SCRIPTCHECK_THREADS
-    script_threads = std::min(script_threads, MAX_SCRIPTCHECK_THREADS);
-
     LogPrintf("Script verification uses %d additional threads\n", script_threads);
     nScriptCheckThreads = script_threads;
     if (script_threads >= 1) {
@@ -1453,6 +1484,20 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         for (int i = 0; i < script_threads; ++i) {
             threadGroup.create_thread([i]() { return ThreadScriptCheck(i); });
         }
+        if (args.GetBoolArg("-prefetchinputs", DEFAULT_PREFETCH_INPUTS)) {
+            g_parallel_prevout_prefetch = true;
+            for (int i = 0; i < script_threads; ++i) {
+                threadGroup.create_thread([i]() { return ThreadPrevoutPrefetch(i); });
+            }
+        }
+        g_preload_blocks = std::max<int64_t>(args.GetArg("-preloadblocks", DEFAULT_PRELOAD_BLOCKS), 0);
+        if (g_preload_blocks > 0) {
+            threadGroup.create_thread(ThreadBlockPreload);
+        }
+    }
+    g_block_read_cache.SetMaxSize(size_t(std::max<int64_t>(args.GetArg("-blockreadcache", DEFAULT_BLOCK_READ_CACHE_SIZE), 0)) << 20);
+    if (args.GetBoolArg("-asyncblockwrites", DEFAULT_ASYNC_BLOCK_WRITES)) {
+        g_block_writer.Start(MAX_PENDING_BLOCK_WRITES);
     }
 
     assert(!node.scheduler);
@@ -1682,6 +1727,7 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
     // because we check for auto only if corruption is detected
     fReindex = args.GetBoolArg("-reindex", false);
     bool fReindexChainState = args.GetBoolArg("-reindex-chainstate", false);
+    g_compress_blocks = args.GetBoolArg("-compressblocks", DEFAULT_COMPRESS_BLOCKS);
 
     // cache size calculations
     int64_t nTotalCache = (args.GetArg("-dbcache", nDefaultDbCache) << 20);
@@ -1953,6 +1999,21 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
         return false;
     }
 
+    // Rewrite the block files in the format selected by -compressblocks
+    bool converted_block_files = false;
+    if (args.GetBoolArg("-convertblocks", false)) {
+        if (fReindex) {
+            LogPrintf("Not converting block files while reindexing\n");
+        } else {
+            uiInterface.InitMessage(_("Converting block files...").translated);
+            if (!ConvertBlockFiles(chainparams, g_compress_blocks)) {
+                if (ShutdownRequested()) return false;
+                return InitError(_("Failed to convert the block files. They will be reindexed on the next start."));
+            }
+            converted_block_files = true;
+        }
+    }
+
     fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
     // Don't initialize fee estimation with old data if we don't relay transactions,
     // as they would never be updated.
@@ -1966,7 +2027,8 @@ bool AppInitMain(const util::Ref& context, NodeContext& node, interfaces::BlockA
 
     // ********************************************************* Step 8: start indexers
     if (args.GetBoolArg("-txindex", DEFAULT_TXINDEX)) {
-        g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex);
+        // The transaction index refers to block positions, which conversion changes.
+        g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex || converted_block_files);
         g_txindex->Start();
     }
 
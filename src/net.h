@@ -20,6 +20,7 @@
 #include <policy/feerate.h>
 #include <protocol.h>
 #include <random.h>
+#include <span.h>
 #include <streams.h>
 #include <sync.h>
 #include <threadinterrupt.h>
@@ -115,6 +116,25 @@ struct CSerializedNetMsg
 
     std::vector<unsigned char> data;
     std::string m_type;
+
+    //! If set, keeps m_payload valid, and m_payload is sent instead of data.
+    std::shared_ptr<const void> m_payload_owner;
+    Span<const unsigned char> m_payload;
+
+    Span<const unsigned char> Payload() const { return m_payload_owner ? m_payload : MakeSpan(data); }
+};
+
+/** Bytes queued for sending to a peer: either owned, or held in place by owner. */
+struct CSendBuffer
+{
+    explicit CSendBuffer(std::vector<unsigned char>&& data_in) : data(std::move(data_in)) {}
+    CSendBuffer(Span<const unsigned char> ref_in, std::shared_ptr<const void> owner_in) : ref(ref_in), owner(std::move(owner_in)) {}
+
+    std::vector<unsigned char> data;
+    Span<const unsigned char> ref;
+    std::shared_ptr<const void> owner;
+
+    Span<const unsigned char> Bytes() const { return owner ? ref : MakeSpan(data); }
 };
 
 /** Different types of connections to a peer. This enum encapsulates the
@@ -883,7 +903,7 @@ public:
     size_t nSendSize{0}; // total size of all vSendMsg entries
     size_t nSendOffset{0}; // offset inside the first vSendMsg already sent
     uint64_t nSendBytes GUARDED_BY(cs_vSend){0};
-    std::deque<std::vector<unsigned char>> vSendMsg GUARDED_BY(cs_vSend);
+    std::deque<CSendBuffer> vSendMsg GUARDED_BY(cs_vSend);
     RecursiveMutex cs_vSend;
     RecursiveMutex cs_hSocket;
     RecursiveMutex cs_vRecv;
@@ -28,6 +28,7 @@
 #include <tinyformat.h>
 #include <txmempool.h>
 #include <util/check.h> // For NDEBUG compile time check
+#include <util/ioprio.h>
 #include <util/strencodings.h>
 #include <util/system.h>
 #include <validation.h>
@@ -1651,19 +1652,28 @@ void static ProcessGetBlockData(CNode& pfrom, const CChainParams& chainparams, c
         } else if (inv.IsMsgWitnessBlk()) {
             // Fast-path: in this case it is possible to serve the block directly from disk,
             // as the network format matches the format on disk
-            std::vector<uint8_t> block_data;
-            if (!ReadRawBlockFromDisk(block_data, pindex, chainparams.MessageStart(), true)) {
-                assert(!"cannot load block from disk");
+            Span<const uint8_t> mapped_block;
+            std::shared_ptr<const void> mapping;
+            if (MapRawBlockFromDisk(mapped_block, mapping, pindex, chainparams.MessageStart())) {
+                // Send the block straight from the mapped file. Computing the
+                // message checksum reads it, so the disk reads happen here
+                // rather than on the socket thread.
+                IOPRIO_IDLER(true);
+                connman.PushMessage(&pfrom, msgMaker.MakeInPlace(NetMsgType::BLOCK, mapped_block, std::move(mapping)));
+            } else {
+                std::shared_ptr<const std::vector<uint8_t>> block_data = ReadRawBlockFromDiskCached(pindex, chainparams.MessageStart(), true);
+                if (!block_data) {
+                    assert(!"cannot load block from disk");
+                }
+                connman.PushMessage(&pfrom, msgMaker.MakeInPlace(NetMsgType::BLOCK, MakeSpan(*block_data), block_data));
             }
-            connman.PushMessage(&pfrom, msgMaker.Make(NetMsgType::BLOCK, MakeSpan(block_data)));
             // Don't set pblock as we've sent the block
         } else {
-            // Send block from disk
-            std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
-            if (!ReadBlockFromDisk(*pblockRead, pindex, consensusParams, true)) {
+            // Send block from disk, or from the cache of recently read blocks
+            pblock = ReadBlockFromDiskCached(pindex, consensusParams, true);
+            if (!pblock) {
                 assert(!"cannot load block from disk");
             }
-            pblock = pblockRead;
         }
         if (pblock) {
             if (inv.IsMsgBlk()) {
@@ -29,6 +29,16 @@ public:
         return Make(0, std::move(msg_type), std::forward<Args>(args)...);
     }
 
+    /** Make a message with an already serialized payload that is sent in place, and kept valid by owner until then. */
+    CSerializedNetMsg MakeInPlace(std::string msg_type, Span<const unsigned char> payload, std::shared_ptr<const void> owner) const
+    {
+        CSerializedNetMsg msg;
+        msg.m_type = std::move(msg_type);
+        msg.m_payload = payload;
+        msg.m_payload_owner = std::move(owner);
+        return msg;
+    }
+
 private:
     const int nVersion;
 };
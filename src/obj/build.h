@@ -0,0 +1 @@
+#define BUILD_GIT_COMMIT "bac47c9-dirty"
@@ -17,7 +17,7 @@
 
 #include <consensus/consensus.h> // for MAX_BLOCK_SERIALIZED_SIZE
 #include <interfaces/node.h>
-#include <validation.h> // for DEFAULT_SCRIPTCHECK_THREADS and MAX_SCRIPTCHECK_THREADS
+#include <validation.h> // for DEFAULT_SCRIPTCHECK_THREADS
 #include <netbase.h>
 #include <primitives/transaction.h> // for WITNESS_SCALE_FACTOR
 #include <txdb.h> // for -dbcache defaults
@@ -97,7 +97,7 @@ OptionsDialog::OptionsDialog(QWidget *parent, bool enableWallet) :
     ui->databaseCache->setMinimum(nMinDbCache);
     ui->databaseCache->setMaximum(nMaxDbCache);
     ui->threadsScriptVerif->setMinimum(-GetNumCores());
-    ui->threadsScriptVerif->setMaximum(MAX_SCRIPTCHECK_THREADS);
+    ui->threadsScriptVerif->setMaximum(GetNumCores());
     ui->pruneWarning->setVisible(false);
     ui->pruneWarning->setStyleSheet("QLabel { color: red; }");
 
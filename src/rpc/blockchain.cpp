@@ -934,14 +934,14 @@ static RPCHelpMan getblockheader()
     };
 }
 
-static CBlock GetBlockChecked(const CBlockIndex* pblockindex)
+static std::shared_ptr<const CBlock> GetBlockChecked(const CBlockIndex* pblockindex)
 {
-    CBlock block;
     if (IsBlockPruned(pblockindex)) {
         throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
     }
 
-    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
+    std::shared_ptr<const CBlock> block = ReadBlockFromDiskCached(pblockindex, Params().GetConsensus());
+    if (!block) {
         // Block not found on disk. This could be because we have the block
         // header in our index but not yet have the block or did not accept the
         // block.
@@ -1037,8 +1037,8 @@ static RPCHelpMan getblock()
             verbosity = request.params[1].get_bool() ? 1 : 0;
     }
 
-    CBlock block;
-    std::vector<uint8_t> raw_block;
+    std::shared_ptr<const CBlock> block;
+    std::shared_ptr<const std::vector<uint8_t>> raw_block;
     const CBlockIndex* pblockindex;
     const CBlockIndex* tip;
     {
@@ -1056,7 +1056,8 @@ static RPCHelpMan getblock()
 
         if (verbosity <= 0 && !RPCSerializationFlags()) {
             // This one case doesn't need to parse the block at all
-            if (!ReadRawBlockFromDisk(raw_block, pblockindex, Params().MessageStart())) {
+            raw_block = ReadRawBlockFromDiskCached(pblockindex, Params().MessageStart());
+            if (!raw_block) {
                 throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
             }
         } else {
@@ -1067,17 +1068,17 @@ static RPCHelpMan getblock()
     if (verbosity <= 0)
     {
         std::string strHex;
-        if (raw_block.empty()) {
+        if (!raw_block) {
             CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-            ssBlock << block;
+            ssBlock << *block;
             strHex = HexStr(ssBlock);
         } else {
-            strHex = HexStr(raw_block);
+            strHex = HexStr(*raw_block);
         }
         return strHex;
     }
 
-    return blockToJSONv(block, tip, pblockindex, verbosity);
+    return blockToJSONv(*block, tip, pblockindex, verbosity);
 },
     };
 }
@@ -2233,7 +2234,8 @@ static RPCHelpMan getblockstats()
         }
     }
 
-    const CBlock block = GetBlockChecked(pindex);
+    const std::shared_ptr<const CBlock> pblock = GetBlockChecked(pindex);
+    const CBlock& block = *pblock;
     const CBlockUndo blockUndo = GetUndoChecked(pindex);
 
     const bool do_all = stats.size() == 0; // Calculate everything if nothing selected (default)
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bech32.h>
+#include <blockcache.h>
 #include <clientversion.h>
 #include <coins.h>
 #include <httpserver.h>
@@ -20,6 +21,7 @@
 #include <rpc/util.h>
 #include <scheduler.h>
 #include <script/descriptor.h>
+#include <script/sigcache.h>
 #include <util/check.h>
 #include <util/message.h> // For MessageSign(), MessageVerify()
 #include <util/ref.h>
@@ -669,6 +671,33 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCSignatureCacheInfo()
+{
+    SignatureCacheStats stats = GetSignatureCacheStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("shards", uint64_t(stats.shards));
+    obj.pushKV("capacity", uint64_t(stats.capacity));
+    obj.pushKV("bytes", uint64_t(stats.bytes));
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    obj.pushKV("hit_rate", stats.hits + stats.misses ? double(stats.hits) / (stats.hits + stats.misses) : 0.0);
+    obj.pushKV("inserts", stats.inserts);
+    obj.pushKV("evictions", stats.evictions);
+    return obj;
+}
+
+static UniValue RPCBlockReadCacheInfo()
+{
+    const CBlockReadCache::Stats stats = g_block_read_cache.GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", uint64_t(stats.entries));
+    obj.pushKV("bytes", uint64_t(stats.bytes));
+    obj.pushKV("max_bytes", uint64_t(stats.max_bytes));
+    obj.pushKV("hits", stats.hits);
+    obj.pushKV("misses", stats.misses);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -713,6 +742,25 @@ static RPCHelpMan getmemoryinfo()
                                 {RPCResult::Type::NUM, "chunks_used", "Number allocated chunks"},
                                 {RPCResult::Type::NUM, "chunks_free", "Number unused chunks"},
                             }},
+                            {RPCResult::Type::OBJ, "sigcache", "Information about the signature cache, with counts since startup",
+                            {
+                                {RPCResult::Type::NUM, "shards", "Number of independently locked parts of the cache"},
+                                {RPCResult::Type::NUM, "capacity", "Number of signatures the cache can hold"},
+                                {RPCResult::Type::NUM, "bytes", "Number of bytes used to hold them (see -maxsigcachesize)"},
+                                {RPCResult::Type::NUM, "hits", "Number of lookups that found the signature in the cache"},
+                                {RPCResult::Type::NUM, "misses", "Number of lookups that did not"},
+                                {RPCResult::Type::NUM, "hit_rate", "hits / (hits + misses), or 0 before the first lookup"},
+                                {RPCResult::Type::NUM, "inserts", "Number of signatures added to the cache"},
+                                {RPCResult::Type::NUM, "evictions", "Number of inserts that pushed another signature out of the cache. Many evictions suggest raising -maxsigcachesize"},
+                            }},
+                            {RPCResult::Type::OBJ, "blockcache", "Information about the cache of recently read blocks, with counts since startup",
+                            {
+                                {RPCResult::Type::NUM, "entries", "Number of cached blocks, counting deserialized and raw copies separately"},
+                                {RPCResult::Type::NUM, "bytes", "Number of bytes used to hold them"},
+                                {RPCResult::Type::NUM, "max_bytes", "Memory limit of the cache (see -blockreadcache)"},
+                                {RPCResult::Type::NUM, "hits", "Number of block reads served from the cache"},
+                                {RPCResult::Type::NUM, "misses", "Number of block reads that went to disk"},
+                            }},
                         }
                     },
                     RPCResult{"mode \"mallocinfo\"",
@@ -729,6 +777,8 @@ static RPCHelpMan getmemoryinfo()
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("sigcache", RPCSignatureCacheInfo());
+        obj.pushKV("blockcache", RPCBlockReadCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
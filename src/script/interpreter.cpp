@@ -1934,7 +1934,133 @@ static bool VerifyWitnessProgram(const CScriptWitness& witness, int witversion,
     // There is intentionally no return statement here, to be able to use "control reaches end of non-void function" warnings to detect gaps in the logic above.
 }
 
+/**
+ * Fast paths for the P2PKH, P2WPKH and P2SH-P2WPKH templates, which make up
+ * most of the inputs we verify. They check the same rules in the same order
+ * as VerifyScriptGeneric() would, but operate on the pushed values directly
+ * instead of copying them around an interpreter stack.
+ */
+static bool IsPayToPubKeyHash(const CScript& script)
+{
+    return script.size() == 25 &&
+           script[0] == OP_DUP &&
+           script[1] == OP_HASH160 &&
+           script[2] == 0x14 &&
+           script[23] == OP_EQUALVERIFY &&
+           script[24] == OP_CHECKSIG;
+}
+
+static bool IsPayToWitnessPubKeyHash(const CScript& script)
+{
+    return script.size() == 22 && script[0] == OP_0 && script[1] == 0x14;
+}
+
+/** Run DUP HASH160 <keyhash> EQUALVERIFY CHECKSIG (given as scriptCode) on the stack [sig, pubkey], and require a true result. */
+static bool ExecuteKeyHash(const valtype& sig, const valtype& pubkey, const unsigned char* keyhash, const CScript& scriptCode, unsigned int flags, SigVersion sigversion, const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    unsigned char hash[CHash160::OUTPUT_SIZE];
+    CHash160().Write(pubkey).Finalize(hash);
+    if (memcmp(hash, keyhash, sizeof(hash))) {
+        return set_error(serror, SCRIPT_ERR_EQUALVERIFY);
+    }
+    bool success = true;
+    if (!EvalChecksigPreTapscript(sig, pubkey, scriptCode.begin(), scriptCode.end(), flags, checker, sigversion, serror, success)) {
+        return false;
+    }
+    if (!success) return set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+    return set_success(serror);
+}
+
+/** Equivalent of VerifyWitnessProgram() followed by ExecuteWitnessScript() for a 20-byte v0 program. */
+static bool VerifyWitnessKeyHash(const CScriptWitness& witness, const valtype& program, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    if (witness.stack.size() != 2) {
+        return set_error(serror, SCRIPT_ERR_WITNESS_PROGRAM_MISMATCH);
+    }
+    for (const valtype& elem : witness.stack) {
+        if (elem.size() > MAX_SCRIPT_ELEMENT_SIZE) return set_error(serror, SCRIPT_ERR_PUSH_SIZE);
+    }
+    CScript scriptCode;
+    scriptCode << OP_DUP << OP_HASH160 << program << OP_EQUALVERIFY << OP_CHECKSIG;
+    return ExecuteKeyHash(witness.stack[0], witness.stack[1], program.data(), scriptCode, flags, SigVersion::WITNESS_V0, checker, serror);
+}
+
+/**
+ * Read the pushes of a scriptSig that consists of exactly `out.size()` data
+ * pushes which EvalScript() would accept. Returns false for anything else,
+ * including scripts EvalScript() would reject, which are left to the generic
+ * path to report.
+ */
+static bool GetSimplePushes(const CScript& scriptSig, unsigned int flags, std::vector<valtype>& out)
+{
+    if (scriptSig.size() > MAX_SCRIPT_SIZE) return false;
+    CScript::const_iterator pc = scriptSig.begin();
+    opcodetype opcode;
+    for (valtype& data : out) {
+        if (!scriptSig.GetOp(pc, opcode, data)) return false;
+        if (opcode > OP_PUSHDATA4 || data.size() > MAX_SCRIPT_ELEMENT_SIZE) return false;
+        if ((flags & SCRIPT_VERIFY_MINIMALDATA) && !CheckMinimalPush(data, opcode)) return false;
+    }
+    return pc == scriptSig.end();
+}
+
+/**
+ * Verify a spend of one of the templates above. Returns false if the spend
+ * does not match one, and otherwise sets `result` (and serror) to what
+ * VerifyScriptGeneric() would return.
+ */
+static bool VerifyScriptTemplate(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness& witness, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror, bool& result)
+{
+    if (IsPayToPubKeyHash(scriptPubKey)) {
+        std::vector<valtype> pushes(2);
+        if (!GetSimplePushes(scriptSig, flags, pushes)) return false;
+        result = ExecuteKeyHash(pushes[0], pushes[1], &scriptPubKey[3], scriptPubKey, flags, SigVersion::BASE, checker, serror);
+        if (result && (flags & SCRIPT_VERIFY_WITNESS) && !witness.IsNull()) {
+            result = set_error(serror, SCRIPT_ERR_WITNESS_UNEXPECTED);
+        }
+        return true;
+    }
+
+    // Witness programs are only special when WITNESS is set, which implies P2SH.
+    if (!(flags & SCRIPT_VERIFY_WITNESS)) return false;
+
+    const unsigned char* program_begin;
+    if (IsPayToWitnessPubKeyHash(scriptPubKey) && scriptSig.empty()) {
+        program_begin = &scriptPubKey[2];
+    } else if (scriptPubKey.IsPayToScriptHash() && scriptSig.size() == 23 &&
+               scriptSig[0] == 22 && scriptSig[1] == OP_0 && scriptSig[2] == 0x14) {
+        // scriptSig is exactly a push of the redeemScript, and the redeemScript is P2WPKH.
+        unsigned char hash[CHash160::OUTPUT_SIZE];
+        CHash160().Write({&scriptSig[1], 22}).Finalize(hash);
+        if (memcmp(hash, &scriptPubKey[2], sizeof(hash))) {
+            result = set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+            return true;
+        }
+        program_begin = &scriptSig[3];
+    } else {
+        return false;
+    }
+    const valtype program(program_begin, program_begin + WITNESS_V0_KEYHASH_SIZE);
+    if (!CastToBool(program)) {
+        result = set_error(serror, SCRIPT_ERR_EVAL_FALSE);
+        return true;
+    }
+    result = VerifyWitnessKeyHash(witness, program, flags, checker, serror);
+    return true;
+}
+
 bool VerifyScript(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness* witness, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
+{
+    static const CScriptWitness emptyWitness;
+    if (witness == nullptr) {
+        witness = &emptyWitness;
+    }
+    bool result;
+    if (VerifyScriptTemplate(scriptSig, scriptPubKey, *witness, flags, checker, serror, result)) return result;
+    return VerifyScriptGeneric(scriptSig, scriptPubKey, witness, flags, checker, serror);
+}
+
+bool VerifyScriptGeneric(const CScript& scriptSig, const CScript& scriptPubKey, const CScriptWitness* witness, unsigned int flags, const BaseSignatureChecker& checker, ScriptError* serror)
 {
     static const CScriptWitness emptyWitness;
     if (witness == nullptr) {
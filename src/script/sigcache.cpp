@@ -11,6 +11,10 @@
 #include <util/system.h>
 
 #include <cuckoocache.h>
+
+#include <array>
+#include <atomic>
+
 #include <boost/thread/shared_mutex.hpp>
 
 namespace {
@@ -18,6 +22,9 @@ namespace {
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * The cache is split into shards with a lock each, so that script check
+ * threads looking up different signatures rarely wait for each other.
  */
 class CSignatureCache
 {
@@ -26,8 +33,24 @@ private:
     CSHA256 m_salted_hasher_ecdsa;
     CSHA256 m_salted_hasher_schnorr;
     typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    boost::shared_mutex cs_sigcache;
+
+    struct alignas(64) Shard {
+        map_type setValid;
+        boost::shared_mutex cs_sigcache;
+        uint32_t nElems{0};
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> inserts{0};
+        std::atomic<uint64_t> evictions{0};
+    };
+    std::array<Shard, SIGNATURE_CACHE_SHARDS> m_shards;
+
+    Shard& GetShard(const uint256& entry)
+    {
+        // SignatureCacheHasher mostly uses the high bits of each 32-bit word
+        // of the entry, so pick the shard with the low bits of the first one.
+        return m_shards[entry.begin()[0] % SIGNATURE_CACHE_SHARDS];
+    }
 
 public:
     CSignatureCache()
@@ -62,18 +85,56 @@ public:
     bool
     Get(const uint256& entry, const bool erase)
     {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
+        Shard& shard = GetShard(entry);
+        bool found;
+        {
+            boost::shared_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+            found = shard.setValid.contains(entry, erase);
+        }
+        (found ? shard.hits : shard.misses).fetch_add(1, std::memory_order_relaxed);
+        return found;
     }
 
     void Set(uint256& entry)
     {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
+        Shard& shard = GetShard(entry);
+        bool evicted;
+        {
+            boost::unique_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+            evicted = !shard.setValid.insert(entry);
+        }
+        shard.inserts.fetch_add(1, std::memory_order_relaxed);
+        if (evicted) shard.evictions.fetch_add(1, std::memory_order_relaxed);
     }
+
+    //! Size the cache to use at most n bytes, split evenly across the shards. Returns the number of elements it can hold.
     uint32_t setup_bytes(size_t n)
     {
-        return setValid.setup_bytes(n);
+        uint32_t nElems = 0;
+        for (Shard& shard : m_shards) {
+            boost::unique_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+            shard.nElems = shard.setValid.setup_bytes(n / SIGNATURE_CACHE_SHARDS);
+            nElems += shard.nElems;
+        }
+        return nElems;
+    }
+
+    SignatureCacheStats GetStats()
+    {
+        SignatureCacheStats stats;
+        stats.shards = m_shards.size();
+        for (Shard& shard : m_shards) {
+            {
+                boost::shared_lock<boost::shared_mutex> lock(shard.cs_sigcache);
+                stats.capacity += shard.nElems;
+            }
+            stats.hits += shard.hits.load(std::memory_order_relaxed);
+            stats.misses += shard.misses.load(std::memory_order_relaxed);
+            stats.inserts += shard.inserts.load(std::memory_order_relaxed);
+            stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+        }
+        stats.bytes = stats.capacity * sizeof(uint256);
+        return stats;
     }
 };
 
@@ -98,6 +159,11 @@ void InitSignatureCache()
             (nElems*sizeof(uint256)) >>20, (nMaxCacheSize*2)>>20, nElems);
 }
 
+SignatureCacheStats GetSignatureCacheStats()
+{
+    return signatureCache.GetStats();
+}
+
 bool CachingTransactionSignatureChecker::VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
@@ -116,7 +182,40 @@ bool CachingTransactionSignatureChecker::VerifySchnorrSignature(Span<const unsig
     uint256 entry;
     signatureCache.ComputeEntrySchnorr(entry, sighash, sig, pubkey);
     if (signatureCache.Get(entry, !store)) return true;
+    if (m_batch) {
+        m_batch->Add(sig, pubkey, sighash, store ? &entry : nullptr);
+        return true;
+    }
     if (!TransactionSignatureChecker::VerifySchnorrSignature(sig, pubkey, sighash)) return false;
     if (store) signatureCache.Set(entry);
     return true;
 }
+
+void CSignatureBatch::Add(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash, const uint256* cache_entry)
+{
+    assert(sig.size() == 64);
+    Entry entry{sighash, pubkey, {}, cache_entry ? *cache_entry : uint256()};
+    std::copy(sig.begin(), sig.end(), entry.sig.begin());
+    m_entries.push_back(std::move(entry));
+}
+
+bool CSignatureBatch::Verify()
+{
+    // The bundled libsecp256k1 has no batch verification API yet, so the
+    // signatures are verified one by one. A batch call belongs here, with
+    // this loop kept to tell valid signatures from the invalid one when it
+    // fails.
+    bool ok = true;
+    for (const Entry& entry : m_entries) {
+        if (!entry.pubkey.VerifySchnorr(entry.sighash, entry.sig)) {
+            ok = false;
+            break;
+        }
+        if (!entry.cache_entry.IsNull()) {
+            uint256 cache_entry = entry.cache_entry;
+            signatureCache.Set(cache_entry);
+        }
+    }
+    m_entries.clear();
+    return ok;
+}
@@ -6,9 +6,11 @@
 #ifndef BITCOIN_SCRIPT_SIGCACHE_H
 #define BITCOIN_SCRIPT_SIGCACHE_H
 
+#include <pubkey.h>
 #include <script/interpreter.h>
 #include <span.h>
 
+#include <array>
 #include <vector>
 
 // DoS prevention: limit cache size to 32MB (over 1000000 entries on 64-bit
@@ -17,8 +19,8 @@
 static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
 // Maximum sig cache size allowed
 static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
-
-class CPubKey;
+// Number of independently locked parts the signature cache is split into
+static const unsigned int SIGNATURE_CACHE_SHARDS = 16;
 
 /**
  * We're hashing a nonce into the entries themselves, so we don't need extra
@@ -41,13 +43,50 @@ public:
     }
 };
 
+/**
+ * Schnorr signature checks deferred by CachingTransactionSignatureChecker, to
+ * be verified together after the scripts they come from have run.
+ *
+ * BIP340 signatures can be deferred because an invalid one always makes its
+ * script fail. ECDSA signatures cannot: a script may go on after a failed
+ * ECDSA check, so those are always verified right away.
+ */
+class CSignatureBatch
+{
+private:
+    struct Entry {
+        uint256 sighash;
+        XOnlyPubKey pubkey;
+        std::array<unsigned char, 64> sig;
+        //! Signature cache entry to add once verified, if nonzero.
+        uint256 cache_entry;
+    };
+    std::vector<Entry> m_entries;
+
+public:
+    void Add(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash, const uint256* cache_entry);
+
+    /**
+     * Verify the signatures added since the last call, and forget them.
+     * Valid signatures added with a cache entry are stored in the cache.
+     */
+    bool Verify();
+
+    //! Forget the signatures added since the last call, without verifying them.
+    void Clear() { m_entries.clear(); }
+
+    size_t size() const { return m_entries.size(); }
+};
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
+    CSignatureBatch* m_batch;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn) {}
+    //! If batch is not nullptr, Schnorr signatures not in the cache are added to it rather than verified.
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn, CSignatureBatch* batch = nullptr) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn), m_batch(batch) {}
 
     bool VerifyECDSASignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
     bool VerifySchnorrSignature(Span<const unsigned char> sig, const XOnlyPubKey& pubkey, const uint256& sighash) const override;
@@ -55,4 +94,19 @@ public:
 
 void InitSignatureCache();
 
+/** Signature cache usage, with counts since startup. */
+struct SignatureCacheStats {
+    size_t shards{0};
+    //! Number of signatures the cache can hold, and the memory used for them.
+    size_t capacity{0};
+    size_t bytes{0};
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t inserts{0};
+    //! Inserts that pushed another signature out of the cache.
+    uint64_t evictions{0};
+};
+
+SignatureCacheStats GetSignatureCacheStats();
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
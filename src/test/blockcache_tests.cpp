@@ -0,0 +1,78 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockcache.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockcache_tests, BasicTestingSetup)
+
+static std::shared_ptr<const std::vector<uint8_t>> RawBlock(size_t size)
+{
+    return std::make_shared<const std::vector<uint8_t>>(size, 0x42);
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_hits_and_misses)
+{
+    CBlockReadCache cache{1 << 20};
+    const uint256 hash = InsecureRand256();
+
+    BOOST_CHECK(!cache.GetRawBlock(hash));
+    const auto raw = RawBlock(1000);
+    cache.AddRawBlock(hash, raw);
+    BOOST_CHECK(cache.GetRawBlock(hash) == raw);
+
+    // Raw and deserialized blocks are cached independently.
+    BOOST_CHECK(!cache.GetBlock(hash));
+    const auto block = std::make_shared<const CBlock>();
+    cache.AddBlock(hash, block);
+    BOOST_CHECK(cache.GetBlock(hash) == block);
+    BOOST_CHECK(cache.GetRawBlock(hash) == raw);
+
+    const CBlockReadCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.hits, 3U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    BOOST_CHECK_GE(stats.bytes, 1000U);
+    BOOST_CHECK_EQUAL(stats.max_bytes, 1U << 20);
+}
+
+BOOST_AUTO_TEST_CASE(blockcache_evicts_least_recently_used)
+{
+    CBlockReadCache cache{100000};
+    std::vector<uint256> hashes;
+    for (int i = 0; i < 4; ++i) {
+        hashes.push_back(InsecureRand256());
+        cache.AddRawBlock(hashes.back(), RawBlock(20000));
+    }
+    BOOST_CHECK(cache.GetStats().bytes <= 100000);
+
+    // Touch the oldest entry, so the second oldest is the one to go.
+    BOOST_CHECK(cache.GetRawBlock(hashes[0]));
+    const uint256 extra = InsecureRand256();
+    cache.AddRawBlock(extra, RawBlock(20000));
+    cache.AddRawBlock(InsecureRand256(), RawBlock(20000));
+    BOOST_CHECK(cache.GetStats().bytes <= 100000);
+    BOOST_CHECK(cache.GetRawBlock(hashes[0]));
+    BOOST_CHECK(!cache.GetRawBlock(hashes[1]));
+    BOOST_CHECK(cache.GetRawBlock(extra));
+
+    // Blocks too large for the cache are not kept.
+    const uint256 large = InsecureRand256();
+    cache.AddRawBlock(large, RawBlock(60000));
+    BOOST_CHECK(!cache.GetRawBlock(large));
+
+    // Shrinking drops entries, and a zero size disables the cache.
+    cache.SetMaxSize(50000);
+    BOOST_CHECK(cache.GetStats().bytes <= 50000);
+    cache.SetMaxSize(0);
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 0U);
+    cache.AddRawBlock(large, RawBlock(10));
+    BOOST_CHECK(!cache.GetRawBlock(large));
+    BOOST_CHECK_EQUAL(cache.GetStats().bytes, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,71 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockpreload.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockpreload_tests, TestingSetup)
+
+//! Wait for the preloader to hand over the block for pindex.
+static std::shared_ptr<const CBlock> WaitForBlock(CBlockPreloader& preloader, const CBlockIndex* pindex)
+{
+    for (int i = 0; i < 1000; ++i) {
+        std::shared_ptr<const CBlock> block = preloader.Take(pindex);
+        if (block) return block;
+        UninterruptibleSleep(std::chrono::milliseconds{10});
+    }
+    return nullptr;
+}
+
+BOOST_AUTO_TEST_CASE(preload_block)
+{
+    const CBlockIndex* genesis = WITH_LOCK(cs_main, return ::ChainActive().Genesis());
+    const FlatFilePos pos = WITH_LOCK(cs_main, return genesis->GetBlockPos());
+
+    CBlockPreloader preloader;
+    boost::thread_group tg;
+    tg.create_thread([&] { preloader.Thread(Params().GetConsensus()); });
+
+    // A preloaded block is read from disk, checked, and handed over once.
+    preloader.Schedule({{genesis, genesis->GetBlockHash(), pos}}, nullptr);
+    std::shared_ptr<const CBlock> block = WaitForBlock(preloader, genesis);
+    BOOST_REQUIRE(block);
+    BOOST_CHECK_EQUAL(block->GetHash(), genesis->GetBlockHash());
+    BOOST_CHECK(block->fChecked);
+    BOOST_CHECK(!preloader.Take(genesis));
+
+    // A block that does not hash to what was requested is not handed over.
+    preloader.Schedule({{genesis, uint256::ONE, pos}}, nullptr);
+    UninterruptibleSleep(std::chrono::milliseconds{100});
+    BOOST_CHECK(!preloader.Take(genesis));
+
+    // Blocks that are no longer scheduled are dropped, whether they were
+    // done or not.
+    preloader.Schedule({{genesis, genesis->GetBlockHash(), pos}}, nullptr);
+    UninterruptibleSleep(std::chrono::milliseconds{100});
+    preloader.Schedule({}, nullptr);
+    BOOST_CHECK(!preloader.Take(genesis));
+    preloader.Schedule({{genesis, genesis->GetBlockHash(), pos}}, nullptr);
+    preloader.Clear();
+    BOOST_CHECK(!preloader.Take(genesis));
+
+    // Blocks still scheduled are kept.
+    preloader.Schedule({{genesis, genesis->GetBlockHash(), pos}}, nullptr);
+    UninterruptibleSleep(std::chrono::milliseconds{100});
+    preloader.Schedule({{genesis, genesis->GetBlockHash(), pos}}, nullptr);
+    BOOST_CHECK(WaitForBlock(preloader, genesis));
+
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,37 @@
+// Copyright (c) 2021 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockscan.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockscan_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(scan_block_files)
+{
+    // Scan the block file written by the test chain, and one that does not exist.
+    CBlockFileScanner scanner(Params(), 2, 2);
+    const CBlockFileScanner::File scanned = scanner.Take(0);
+    BOOST_CHECK(scanned.opened);
+    BOOST_CHECK(!scanner.Take(1).opened);
+
+    LOCK(cs_main);
+    BOOST_CHECK_EQUAL(scanned.blocks.size(), size_t(::ChainActive().Height() + 1));
+    for (const auto& block : scanned.blocks) {
+        const CBlockIndex* pindex = LookupBlockIndex(block.first->GetHash());
+        BOOST_REQUIRE(pindex);
+        BOOST_CHECK(block.first->fChecked);
+        BOOST_CHECK(block.second == pindex->GetBlockPos());
+    }
+    // The blocks are handed over in file order.
+    BOOST_CHECK_EQUAL(scanned.blocks.front().first->GetHash(), ::ChainActive().Genesis()->GetBlockHash());
+    BOOST_CHECK_EQUAL(scanned.blocks.back().first->GetHash(), ::ChainActive().Tip()->GetBlockHash());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
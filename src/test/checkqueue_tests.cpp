@@ -57,6 +57,32 @@ struct FailingCheck {
     };
 };
 
+struct DeferredCheck {
+    bool fails;
+    DeferredCheck(bool _fails) : fails(_fails){};
+    DeferredCheck() : fails(false){};
+    void swap(DeferredCheck& x) { std::swap(fails, x.fails); };
+};
+
+//! Batch that only finds out whether its DeferredChecks fail in Verify().
+struct DeferredBatch {
+    static std::atomic<size_t> n_deferred;
+    bool any_fails{false};
+    bool Run(DeferredCheck& check)
+    {
+        n_deferred.fetch_add(1, std::memory_order_relaxed);
+        any_fails |= check.fails;
+        return true;
+    }
+    bool Verify()
+    {
+        bool ok = !any_fails;
+        any_fails = false;
+        return ok;
+    }
+    void Clear() { any_fails = false; }
+};
+
 struct UniqueCheck {
     static Mutex m;
     static std::unordered_multiset<size_t> results GUARDED_BY(m);
@@ -132,6 +158,7 @@ Mutex UniqueCheck::m;
 std::unordered_multiset<size_t> UniqueCheck::results;
 std::atomic<size_t> FakeCheckCheckCompletion::n_calls{0};
 std::atomic<size_t> MemoryCheck::fake_allocated_memory{0};
+std::atomic<size_t> DeferredBatch::n_deferred{0};
 
 // Queue Typedefs
 typedef CCheckQueue<FakeCheckCheckCompletion> Correct_Queue;
@@ -140,16 +167,17 @@ typedef CCheckQueue<FailingCheck> Failing_Queue;
 typedef CCheckQueue<UniqueCheck> Unique_Queue;
 typedef CCheckQueue<MemoryCheck> Memory_Queue;
 typedef CCheckQueue<FrozenCleanupCheck> FrozenCleanup_Queue;
+typedef CCheckQueue<DeferredCheck, DeferredBatch> Deferred_Queue;
 
 
 /** This test case checks that the CCheckQueue works properly
  * with each specified size_t Checks pushed.
  */
-static void Correct_Queue_range(std::vector<size_t> range)
+static void Correct_Queue_range(std::vector<size_t> range, int threads = SCRIPT_CHECK_THREADS)
 {
     auto small_queue = MakeUnique<Correct_Queue>(QUEUE_BATCH_SIZE);
     boost::thread_group tg;
-    for (auto x = 0; x < SCRIPT_CHECK_THREADS; ++x) {
+    for (auto x = 0; x < threads; ++x) {
        tg.create_thread([&]{small_queue->Thread();});
     }
     // Make vChecks here to save on malloc (this test can be slow...)
@@ -206,6 +234,12 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_Random)
         range.push_back(i);
     Correct_Queue_range(range);
 }
+/** Test that many more workers than checks per batch is correct
+ */
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Correct_ManyWorkers)
+{
+    Correct_Queue_range({0, 1, 2, 31, 32, 33, 1000, 10000}, 63);
+}
 
 
 /** Test that failing checks are caught */
@@ -240,6 +274,30 @@ BOOST_AUTO_TEST_CASE(test_CheckQueue_Catches_Failure)
     tg.interrupt_all();
     tg.join_all();
 }
+// Test that work deferred to the batch is verified, and that its failure is
+// caught and cleared like that of any other check.
+BOOST_AUTO_TEST_CASE(test_CheckQueue_Batch)
+{
+    auto deferred_queue = MakeUnique<Deferred_Queue>(QUEUE_BATCH_SIZE);
+    boost::thread_group tg;
+    for (auto x = 0; x < SCRIPT_CHECK_THREADS; ++x) {
+       tg.create_thread([&]{deferred_queue->Thread();});
+    }
+
+    for (auto times = 0; times < 10; ++times) {
+        for (const bool one_fails : {true, false}) {
+            DeferredBatch::n_deferred = 0;
+            CCheckQueueControl<DeferredCheck, DeferredBatch> control(deferred_queue.get());
+            std::vector<DeferredCheck> vChecks(1000);
+            if (one_fails) vChecks[InsecureRandRange(vChecks.size())].fails = true;
+            control.Add(vChecks);
+            BOOST_REQUIRE_EQUAL(control.Wait(), !one_fails);
+            if (!one_fails) BOOST_REQUIRE_EQUAL(DeferredBatch::n_deferred, 1000U);
+        }
+    }
+    tg.interrupt_all();
+    tg.join_all();
+}
 // Test that a block validation which fails does not interfere with
 // future blocks, ie, the bad state is cleared.
 BOOST_AUTO_TEST_CASE(test_CheckQueue_Recovers_From_Failure)
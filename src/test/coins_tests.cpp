@@ -3,8 +3,11 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <attributes.h>
+#include <checkqueue.h>
 #include <clientversion.h>
 #include <coins.h>
+#include <coinsprefetch.h>
+#include <primitives/block.h>
 #include <script/standard.h>
 #include <streams.h>
 #include <test/util/setup_common.h>
@@ -14,9 +17,11 @@
 #include <util/strencodings.h>
 
 #include <map>
+#include <mutex>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
 
 int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out);
 void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, CTxUndo &txundo, int nHeight);
@@ -54,7 +59,7 @@ public:
 
     uint256 GetBestBlock() const override { return hashBestBlock_; }
 
-    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock) override
+    bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase = true) override
     {
         for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); ) {
             if (it->second.flags & CCoinsCacheEntry::DIRTY) {
@@ -65,7 +70,7 @@ public:
                     map_.erase(it->first);
                 }
             }
-            mapCoins.erase(it++);
+            it = erase ? mapCoins.erase(it) : std::next(it);
         }
         if (!hashBlock.IsNull())
             hashBestBlock_ = hashBlock;
@@ -213,11 +218,11 @@ void SimulationTest(CCoinsView* base, bool fake_best_block)
         }
 
         if (InsecureRandRange(100) == 0) {
-            // Every 100 iterations, flush an intermediate cache
+            // Every 100 iterations, flush or sync an intermediate cache
             if (stack.size() > 1 && InsecureRandBool() == 0) {
                 unsigned int flushIndex = InsecureRandRange(stack.size() - 1);
                 if (fake_best_block) stack[flushIndex]->SetBestBlock(InsecureRand256());
-                BOOST_CHECK(stack[flushIndex]->Flush());
+                BOOST_CHECK(InsecureRandBool() ? stack[flushIndex]->Flush() : stack[flushIndex]->Sync());
             }
         }
         if (InsecureRandRange(100) == 0) {
@@ -461,10 +466,10 @@ BOOST_AUTO_TEST_CASE(updatecoins_simulation_test)
         }
 
         if (InsecureRandRange(100) == 0) {
-            // Every 100 iterations, flush an intermediate cache
+            // Every 100 iterations, flush or sync an intermediate cache
             if (stack.size() > 1 && InsecureRandBool() == 0) {
                 unsigned int flushIndex = InsecureRandRange(stack.size() - 1);
-                BOOST_CHECK(stack[flushIndex]->Flush());
+                BOOST_CHECK(InsecureRandBool() ? stack[flushIndex]->Flush() : stack[flushIndex]->Sync());
             }
         }
         if (InsecureRandRange(100) == 0) {
@@ -609,7 +614,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map{0, CCoinsMap::hasher{}, CCoinsMap::key_equal{}, &resource};
     InsertCoinsMapEntry(map, value, flags);
     BOOST_CHECK(view.BatchWrite(map, {}));
 }
@@ -878,4 +884,162 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_sync_and_trim)
+{
+    CCoinsViewTest base;
+    CCoinsViewCacheTest cache(&base);
+    const CScript script = CScript() << OP_TRUE;
+
+    // Coins at heights 1..100, one of which gets spent.
+    std::vector<COutPoint> outpoints;
+    for (int height = 1; height <= 100; ++height) {
+        outpoints.emplace_back(InsecureRand256(), 0);
+        cache.AddCoin(outpoints.back(), Coin(CTxOut(height, script), height, false), false);
+    }
+    cache.SetBestBlock(InsecureRand256());
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(cache.SpendCoin(outpoints[0]));
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoints[0]));
+
+    // Write the spend and keep every unspent coin cached, but clean.
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 99U);
+    for (const auto& entry : cache.map()) {
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+    }
+    // CCoinsViewTest may keep spent coins around, and randomly report them.
+    Coin coin;
+    BOOST_CHECK(!base.GetCoin(outpoints[0], coin) || coin.IsSpent());
+    BOOST_CHECK(base.GetCoin(outpoints[1], coin));
+    BOOST_CHECK_EQUAL(coin.nHeight, 2U);
+    cache.SelfTest();
+
+    // A modified coin is never evicted, however old it is.
+    Coin moved;
+    BOOST_CHECK(cache.SpendCoin(outpoints[1], &moved));
+    cache.AddCoin(outpoints[1], std::move(moved), true);
+
+    // Evicting the old half of the clean coins frees memory for reuse.
+    const size_t in_use = cache.DynamicMemoryUsage() - cache.ReusableMemoryUsage();
+    const size_t coins_before = cache.GetCacheSize();
+    size_t evicted = cache.Trim(in_use - 1);
+    BOOST_CHECK(evicted > 0);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), coins_before - evicted);
+    BOOST_CHECK(cache.DynamicMemoryUsage() - cache.ReusableMemoryUsage() < in_use);
+    BOOST_CHECK(cache.HaveCoinInCache(outpoints[1]));
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoints[2]));
+    BOOST_CHECK(cache.HaveCoinInCache(outpoints.back()));
+    cache.SelfTest();
+
+    // Trimming to nothing leaves only the modified coin, which still gets written.
+    cache.Trim(0);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 1U);
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(base.GetCoin(outpoints.back(), coin));
+    BOOST_CHECK(base.GetCoin(outpoints[1], coin));
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_async_flush)
+{
+    //! Base view whose writes wait until the test releases gate.
+    class CCoinsViewGatedTest : public CCoinsViewTest
+    {
+    public:
+        std::mutex gate;
+        bool BatchWrite(CCoinsMap& mapCoins, const uint256& hashBlock, bool erase = true) override
+        {
+            std::lock_guard<std::mutex> lock(gate);
+            return CCoinsViewTest::BatchWrite(mapCoins, hashBlock, erase);
+        }
+    };
+    CCoinsViewGatedTest base;
+    CCoinsViewAsyncFlush flush_view(&base, /* async */ true);
+    CCoinsViewCacheTest cache(&flush_view);
+    const COutPoint outpoint(InsecureRand256(), 0);
+    const uint256 block1 = InsecureRand256();
+    const uint256 block2 = InsecureRand256();
+
+    // While the write is held up, the coin is served from the flush view.
+    base.gate.lock();
+    cache.AddCoin(outpoint, Coin(CTxOut(1, CScript() << OP_TRUE), 1, false), false);
+    cache.SetBestBlock(block1);
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(!base.HaveCoin(outpoint));
+    BOOST_CHECK(flush_view.HaveCoin(outpoint));
+    BOOST_CHECK(flush_view.GetBestBlock() == block1);
+    base.gate.unlock();
+    BOOST_CHECK(flush_view.WaitForFlush());
+    BOOST_CHECK(base.HaveCoin(outpoint));
+    BOOST_CHECK(base.GetBestBlock() == block1);
+
+    // A spend being written hides the coin still in the base view.
+    base.gate.lock();
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    cache.SetBestBlock(block2);
+    BOOST_CHECK(cache.Sync());
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK(!cache.HaveCoin(outpoint));
+    BOOST_CHECK(base.HaveCoin(outpoint));
+    base.gate.unlock();
+    BOOST_CHECK(flush_view.WaitForFlush());
+    Coin coin;
+    BOOST_CHECK(!base.GetCoin(outpoint, coin) || coin.IsSpent());
+    BOOST_CHECK(base.GetBestBlock() == block2);
+}
+
+BOOST_AUTO_TEST_CASE(coins_prefetch_block_inputs)
+{
+    CCoinsViewTest base;
+    const CScript script = CScript() << OP_TRUE;
+
+    // Two coins in the base view, one of which is already modified in the cache.
+    const COutPoint in_base{InsecureRand256(), 0};
+    const COutPoint in_cache{InsecureRand256(), 1};
+    const COutPoint missing{InsecureRand256(), 2};
+    {
+        CCoinsViewCacheTest writer(&base);
+        writer.AddCoin(in_base, Coin(CTxOut(1, script), 1, false), false);
+        writer.AddCoin(in_cache, Coin(CTxOut(2, script), 1, false), false);
+        writer.SetBestBlock(InsecureRand256());
+        BOOST_CHECK(writer.Flush());
+    }
+    CCoinsViewCacheTest cache(&base);
+    cache.AddCoin(in_cache, Coin(CTxOut(3, script), 2, false), true);
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.emplace_back(50, script);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    CMutableTransaction spend;
+    spend.vin = {CTxIn(in_base), CTxIn(in_cache), CTxIn(missing)};
+    spend.vout.emplace_back(1, script);
+    block.vtx.push_back(MakeTransactionRef(spend));
+    CMutableTransaction child;
+    child.vin = {CTxIn(COutPoint(block.vtx[1]->GetHash(), 0))};
+    child.vout.emplace_back(1, script);
+    block.vtx.push_back(MakeTransactionRef(child));
+
+    CCheckQueue<CCoinsPrefetchCheck> queue{4};
+    boost::thread_group tg;
+    for (int i = 0; i < 2; ++i) {
+        tg.create_thread([&] { queue.Thread(); });
+    }
+
+    // Only the coin that was neither cached nor created in the block is added, as a clean entry.
+    BOOST_CHECK_EQUAL(PrefetchBlockInputs(block, cache, base, queue), 1U);
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 2U);
+    BOOST_CHECK(cache.map().at(in_base).flags == 0);
+    BOOST_CHECK(cache.map().at(in_base).coin.out.nValue == 1);
+    BOOST_CHECK(cache.map().at(in_cache).coin.out.nValue == 3);
+    BOOST_CHECK(!cache.HaveCoinInCache(missing));
+    cache.SelfTest();
+
+    // A second pass has nothing left to do.
+    BOOST_CHECK_EQUAL(PrefetchBlockInputs(block, cache, base, queue), 0U);
+
+    tg.interrupt_all();
+    tg.join_all();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,7 +3,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <compressor.h>
+#include <consensus/merkle.h>
 #include <script/standard.h>
+#include <streams.h>
 #include <test/util/setup_common.h>
 
 #include <stdint.h>
@@ -134,4 +136,71 @@ BOOST_AUTO_TEST_CASE(compress_script_to_uncompressed_pubkey_id)
     BOOST_CHECK_EQUAL(out[0], 0x04 | (script[65] & 0x01)); // least significant bit (lsb) of last char of pubkey is mapped into out[0]
 }
 
+BOOST_AUTO_TEST_CASE(compress_block)
+{
+    CKey key;
+    key.MakeNewKey(false);
+    const CPubKey pubkey = key.GetPubKey();
+
+    CBlock block;
+    block.nVersion = 0x20000000;
+    block.hashPrevBlock = InsecureRand256();
+    block.nTime = 1600000000;
+    block.nBits = 0x207fffff;
+    block.nNonce = 42;
+
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].scriptSig = CScript() << 101 << OP_0;
+    coinbase.vin[0].scriptWitness.stack.push_back(std::vector<unsigned char>(32, 0));
+    coinbase.vout.emplace_back(50 * COIN, GetScriptForDestination(WitnessV0KeyHash(pubkey)));
+    coinbase.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>(36, 0xaa));
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+
+    // All kinds of integers, and outputs ScriptCompression has special cases for.
+    for (int i = 0; i < 20; ++i) {
+        CMutableTransaction tx;
+        tx.nVersion = i % 3 == 0 ? -1 : int32_t(InsecureRand32());
+        tx.nLockTime = i % 2 ? 0 : InsecureRand32();
+        tx.vin.resize(1 + i % 3);
+        for (CTxIn& txin : tx.vin) {
+            txin.prevout = COutPoint(InsecureRand256(), i % 4 == 0 ? 0xffffffff : InsecureRandRange(1000));
+            txin.nSequence = i % 5 == 0 ? InsecureRand32() : CTxIn::SEQUENCE_FINAL - i % 3;
+            txin.scriptSig = CScript() << std::vector<unsigned char>(71, 0x30) << ToByteVector(pubkey);
+            if (i % 2) txin.scriptWitness.stack = {std::vector<unsigned char>(72, 0x30), ToByteVector(pubkey)};
+        }
+        tx.vout.emplace_back(InsecureRandRange(MAX_MONEY), GetScriptForDestination(PKHash(pubkey)));
+        tx.vout.emplace_back(i * COIN / 100, GetScriptForDestination(ScriptHash(CScript() << OP_TRUE)));
+        tx.vout.emplace_back(546, CScript() << ToByteVector(pubkey) << OP_CHECKSIG);
+        tx.vout.emplace_back(MAX_MONEY, CScript() << std::vector<unsigned char>(i * 10, 0x51));
+        block.vtx.push_back(MakeTransactionRef(tx));
+    }
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    BOOST_CHECK(IsBlockCompressible(block));
+
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << Using<BlockCompression>(block);
+    BOOST_CHECK_LT(ss.size(), ::GetSerializeSize(block, PROTOCOL_VERSION));
+    CBlock block2;
+    ss >> Using<BlockCompression>(block2);
+    BOOST_CHECK(ss.empty());
+
+    // Both the header and every transaction, including witnesses, are restored.
+    BOOST_CHECK_EQUAL(block2.GetHash(), block.GetHash());
+    BOOST_REQUIRE_EQUAL(block2.vtx.size(), block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        BOOST_CHECK_EQUAL(block2.vtx[i]->GetWitnessHash(), block.vtx[i]->GetWitnessHash());
+    }
+    BOOST_CHECK(::SerializeHash(block2, SER_NETWORK, PROTOCOL_VERSION) == ::SerializeHash(block, SER_NETWORK, PROTOCOL_VERSION));
+
+    // Outputs that would not survive compression keep the block uncompressed.
+    CMutableTransaction tx(*block.vtx.back());
+    tx.vout.emplace_back(0, CScript() << std::vector<unsigned char>(MAX_SCRIPT_SIZE, 0x51));
+    block.vtx.back() = MakeTransactionRef(tx);
+    BOOST_CHECK(!IsBlockCompressible(block));
+    tx.vout.back() = CTxOut(MAX_MONEY + 1, CScript());
+    block.vtx.back() = MakeTransactionRef(tx);
+    BOOST_CHECK(!IsBlockCompressible(block));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -42,6 +42,30 @@ BOOST_AUTO_TEST_CASE(test_cuckoocache_no_fakes)
     }
 };
 
+/** Check that insert() only reports an eviction once the cache is full.
+ */
+BOOST_AUTO_TEST_CASE(cuckoocache_insert_reports_evictions)
+{
+    SeedInsecureRand(SeedRand::ZEROS);
+    CuckooCache::cache<uint256, SignatureCacheHasher> cc{};
+    uint32_t n_elems = cc.setup_bytes(1 << 20);
+    uint32_t evictions = 0;
+    // Well below capacity, every element finds a slot.
+    for (uint32_t x = 0; x < n_elems / 4; ++x) {
+        if (!cc.insert(InsecureRand256())) ++evictions;
+    }
+    BOOST_CHECK_EQUAL(evictions, 0U);
+    // Inserting an element that is already present is not an eviction.
+    uint256 h = InsecureRand256();
+    BOOST_CHECK(cc.insert(h));
+    BOOST_CHECK(cc.insert(h));
+    // Overfilling the cache must evict.
+    for (uint32_t x = 0; x < 2 * n_elems; ++x) {
+        if (!cc.insert(InsecureRand256())) ++evictions;
+    }
+    BOOST_CHECK(evictions > 0);
+};
+
 /** This helper returns the hit rate when megabytes*load worth of entries are
  * inserted into a megabytes sized cache
  */
@@ -0,0 +1,2138 @@
+namespace json_tests{
+static unsigned const char key_io_valid[] = {
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x31,  0x42,  0x53,  0x68,  0x4a,  0x5a,  0x38, 
+0x41,  0x35,  0x71,  0x35,  0x33,  0x6f,  0x4a,  0x4a, 
+0x66,  0x4d,  0x4a,  0x6f,  0x45,  0x46,  0x31,  0x67, 
+0x66,  0x5a,  0x43,  0x57,  0x64,  0x5a,  0x71,  0x5a, 
+0x77,  0x77,  0x44,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x37, 
+0x36,  0x61,  0x39,  0x31,  0x34,  0x37,  0x32,  0x38, 
+0x64,  0x34,  0x63,  0x63,  0x32,  0x37,  0x64,  0x31, 
+0x39,  0x37,  0x30,  0x37,  0x62,  0x30,  0x31,  0x39, 
+0x37,  0x63,  0x66,  0x63,  0x64,  0x37,  0x63,  0x34, 
+0x31,  0x32,  0x64,  0x34,  0x33,  0x32,  0x38,  0x37, 
+0x38,  0x36,  0x34,  0x62,  0x35,  0x38,  0x38,  0x61, 
+0x63,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e, 
+0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69,  0x6e, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x33,  0x4c,  0x31,  0x59,  0x6b,  0x5a, 
+0x6a,  0x64,  0x65,  0x4e,  0x53,  0x71,  0x61,  0x5a, 
+0x63,  0x4e,  0x4b,  0x5a,  0x46,  0x58,  0x51,  0x66, 
+0x79,  0x6f,  0x6b,  0x78,  0x33,  0x7a,  0x56,  0x59, 
+0x6d,  0x37,  0x72,  0x36,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x61,  0x39,  0x31,  0x34,  0x63,  0x38,  0x66,  0x33, 
+0x37,  0x63,  0x33,  0x63,  0x63,  0x32,  0x31,  0x35, 
+0x36,  0x31,  0x32,  0x39,  0x36,  0x61,  0x64,  0x38, 
+0x31,  0x66,  0x34,  0x62,  0x65,  0x63,  0x36,  0x62, 
+0x35,  0x64,  0x65,  0x31,  0x30,  0x65,  0x62,  0x63, 
+0x31,  0x38,  0x35,  0x31,  0x38,  0x37,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x6d,  0x61,  0x69,  0x6e,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x6d, 
+0x68,  0x4a,  0x75,  0x6f,  0x47,  0x4c,  0x67,  0x6e, 
+0x4a,  0x43,  0x38,  0x67,  0x64,  0x42,  0x67,  0x42, 
+0x7a,  0x45,  0x69,  0x67,  0x73,  0x6f,  0x79,  0x47, 
+0x34,  0x6f,  0x6d,  0x51,  0x58,  0x65,  0x6a,  0x50, 
+0x54,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x37,  0x36,  0x61, 
+0x39,  0x31,  0x34,  0x31,  0x33,  0x61,  0x39,  0x32, 
+0x64,  0x31,  0x39,  0x39,  0x38,  0x65,  0x30,  0x38, 
+0x31,  0x33,  0x35,  0x34,  0x64,  0x33,  0x36,  0x63, 
+0x31,  0x33,  0x63,  0x65,  0x30,  0x63,  0x39,  0x64, 
+0x63,  0x30,  0x34,  0x62,  0x38,  0x36,  0x35,  0x64, 
+0x34,  0x30,  0x61,  0x38,  0x38,  0x61,  0x63,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x32,  0x4e,  0x35,  0x56,  0x70,  0x7a,  0x4b,  0x45, 
+0x75,  0x59,  0x76,  0x5a,  0x4a,  0x62,  0x6d,  0x67, 
+0x36,  0x65,  0x55,  0x4e,  0x47,  0x6e,  0x66,  0x72, 
+0x72,  0x44,  0x31,  0x69,  0x72,  0x39,  0x32,  0x46, 
+0x57,  0x47,  0x75,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x61, 
+0x39,  0x31,  0x34,  0x38,  0x36,  0x36,  0x34,  0x38, 
+0x63,  0x63,  0x32,  0x66,  0x61,  0x61,  0x66,  0x30, 
+0x35,  0x36,  0x36,  0x30,  0x65,  0x37,  0x32,  0x63, 
+0x30,  0x34,  0x63,  0x37,  0x61,  0x38,  0x33,  0x37, 
+0x62,  0x63,  0x63,  0x33,  0x65,  0x39,  0x38,  0x36, 
+0x66,  0x31,  0x37,  0x38,  0x37,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72, 
+0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20, 
+0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x6d,  0x74, 
+0x51,  0x75,  0x65,  0x43,  0x74,  0x6d,  0x41,  0x6e, 
+0x50,  0x33,  0x45,  0x34,  0x61,  0x42,  0x48,  0x58, 
+0x43,  0x69,  0x46,  0x4e,  0x45,  0x51,  0x41,  0x75, 
+0x50,  0x61,  0x4c,  0x4d,  0x75,  0x51,  0x4e,  0x79, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x37,  0x36,  0x61,  0x39, 
+0x31,  0x34,  0x38,  0x64,  0x37,  0x34,  0x65,  0x63, 
+0x64,  0x38,  0x36,  0x63,  0x38,  0x34,  0x35,  0x62, 
+0x61,  0x66,  0x39,  0x63,  0x36,  0x64,  0x34,  0x34, 
+0x38,  0x34,  0x64,  0x32,  0x64,  0x30,  0x30,  0x65, 
+0x37,  0x33,  0x31,  0x62,  0x37,  0x39,  0x65,  0x33, 
+0x34,  0x37,  0x38,  0x38,  0x61,  0x63,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x73,  0x69,  0x67,  0x6e,  0x65,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x32,  0x4e,  0x45,  0x76,  0x57,  0x52,  0x54, 
+0x48,  0x6a,  0x68,  0x38,  0x39,  0x67,  0x56,  0x35, 
+0x32,  0x66,  0x6b,  0x70,  0x65,  0x72,  0x46,  0x74, 
+0x77,  0x7a,  0x6f,  0x46,  0x57,  0x51,  0x69,  0x51, 
+0x6d,  0x69,  0x43,  0x68,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x61,  0x39,  0x31,  0x34,  0x65,  0x64,  0x63,  0x38, 
+0x39,  0x35,  0x31,  0x35,  0x32,  0x63,  0x36,  0x37, 
+0x63,  0x63,  0x66,  0x66,  0x30,  0x62,  0x61,  0x36, 
+0x32,  0x30,  0x62,  0x63,  0x63,  0x33,  0x37,  0x33, 
+0x62,  0x37,  0x38,  0x39,  0x65,  0x63,  0x36,  0x38, 
+0x32,  0x36,  0x36,  0x66,  0x38,  0x37,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x73,  0x69,  0x67,  0x6e,  0x65,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x6d,  0x6e,  0x67,  0x64,  0x78,  0x39,  0x34, 
+0x71,  0x4a,  0x46,  0x68,  0x53,  0x66,  0x37,  0x41, 
+0x37,  0x53,  0x41,  0x45,  0x67,  0x51,  0x53,  0x43, 
+0x39,  0x66,  0x51,  0x4a,  0x75,  0x61,  0x70,  0x75, 
+0x6a,  0x4a,  0x70,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x37, 
+0x36,  0x61,  0x39,  0x31,  0x34,  0x34,  0x65,  0x39, 
+0x64,  0x62,  0x61,  0x35,  0x34,  0x35,  0x34,  0x35, 
+0x35,  0x61,  0x38,  0x30,  0x63,  0x65,  0x39,  0x34, 
+0x63,  0x33,  0x34,  0x33,  0x64,  0x31,  0x63,  0x61, 
+0x63,  0x39,  0x64,  0x65,  0x63,  0x36,  0x32,  0x63, 
+0x62,  0x66,  0x32,  0x32,  0x32,  0x38,  0x38,  0x61, 
+0x63,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e, 
+0x22,  0x3a,  0x20,  0x22,  0x72,  0x65,  0x67,  0x74, 
+0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69, 
+0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66, 
+0x61,  0x6c,  0x73,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x32,  0x4e,  0x42, 
+0x7a,  0x52,  0x4e,  0x33,  0x70,  0x56,  0x35,  0x36, 
+0x6b,  0x33,  0x4a,  0x55,  0x76,  0x53,  0x48,  0x69, 
+0x66,  0x61,  0x48,  0x79,  0x7a,  0x6a,  0x47,  0x48, 
+0x76,  0x37,  0x5a,  0x53,  0x39,  0x46,  0x5a,  0x5a, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x61,  0x39,  0x31,  0x34, 
+0x63,  0x64,  0x39,  0x64,  0x61,  0x35,  0x36,  0x34, 
+0x32,  0x34,  0x35,  0x31,  0x32,  0x37,  0x33,  0x65, 
+0x35,  0x62,  0x36,  0x64,  0x30,  0x38,  0x38,  0x38, 
+0x35,  0x34,  0x63,  0x63,  0x31,  0x66,  0x61,  0x64, 
+0x34,  0x61,  0x38,  0x64,  0x34,  0x34,  0x32,  0x31, 
+0x38,  0x37,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72,  0x65,  0x67, 
+0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72, 
+0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20, 
+0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x4b, 
+0x63,  0x72,  0x46,  0x5a,  0x76,  0x4a,  0x32,  0x70, 
+0x34,  0x64,  0x4d,  0x36,  0x51,  0x56,  0x55,  0x50, 
+0x75,  0x35,  0x33,  0x63,  0x4b,  0x58,  0x63,  0x43, 
+0x66,  0x6f,  0x7a,  0x41,  0x31,  0x50,  0x4a,  0x4c, 
+0x48,  0x6d,  0x31,  0x6d,  0x4e,  0x41,  0x78,  0x6b, 
+0x44,  0x59,  0x68,  0x67,  0x54,  0x68,  0x4c,  0x75, 
+0x34,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x65,  0x64,  0x36, 
+0x63,  0x37,  0x39,  0x36,  0x65,  0x32,  0x66,  0x36, 
+0x32,  0x33,  0x37,  0x37,  0x34,  0x31,  0x30,  0x37, 
+0x36,  0x36,  0x32,  0x31,  0x34,  0x66,  0x35,  0x35, 
+0x61,  0x61,  0x38,  0x31,  0x61,  0x63,  0x39,  0x61, 
+0x36,  0x35,  0x39,  0x30,  0x61,  0x64,  0x37,  0x65, 
+0x64,  0x35,  0x37,  0x63,  0x35,  0x30,  0x39,  0x63, 
+0x39,  0x38,  0x33,  0x62,  0x66,  0x36,  0x34,  0x38, 
+0x34,  0x30,  0x39,  0x61,  0x63,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x6d,  0x61,  0x69,  0x6e,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x43,  0x6f, 
+0x6d,  0x70,  0x72,  0x65,  0x73,  0x73,  0x65,  0x64, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x4c,  0x31,  0x39,  0x35,  0x57,  0x42,  0x72,  0x66, 
+0x32,  0x47,  0x33,  0x6e,  0x43,  0x6e,  0x75,  0x6e, 
+0x34,  0x43,  0x4c,  0x78,  0x72,  0x62,  0x38,  0x58, 
+0x4b,  0x6b,  0x39,  0x4c,  0x62,  0x43,  0x71,  0x48, 
+0x34,  0x33,  0x54,  0x48,  0x68,  0x34,  0x6e,  0x34, 
+0x51,  0x72,  0x4c,  0x35,  0x53,  0x7a,  0x52,  0x7a, 
+0x70,  0x71,  0x39,  0x6a,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x37,  0x34,  0x66,  0x37,  0x36,  0x63,  0x31,  0x30, 
+0x36,  0x65,  0x33,  0x38,  0x64,  0x32,  0x30,  0x35, 
+0x31,  0x34,  0x61,  0x39,  0x39,  0x61,  0x38,  0x36, 
+0x65,  0x34,  0x66,  0x65,  0x33,  0x62,  0x62,  0x32, 
+0x38,  0x33,  0x31,  0x39,  0x65,  0x37,  0x64,  0x64, 
+0x32,  0x61,  0x64,  0x32,  0x31,  0x64,  0x62,  0x63, 
+0x31,  0x37,  0x30,  0x63,  0x62,  0x62,  0x35,  0x31, 
+0x36,  0x61,  0x35,  0x33,  0x35,  0x38,  0x66,  0x61, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69,  0x6e,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65,  0x73, 
+0x73,  0x65,  0x64,  0x22,  0x3a,  0x20,  0x74,  0x72, 
+0x75,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x39,  0x32,  0x7a,  0x36,  0x48,  0x6e, 
+0x4d,  0x51,  0x52,  0x34,  0x74,  0x57,  0x71,  0x6a, 
+0x66,  0x56,  0x41,  0x33,  0x55,  0x61,  0x55,  0x4e, 
+0x35,  0x45,  0x75,  0x55,  0x4d,  0x67,  0x6f,  0x56, 
+0x4d,  0x64,  0x43,  0x61,  0x35,  0x72,  0x5a,  0x46, 
+0x59,  0x5a,  0x66,  0x6d,  0x67,  0x79,  0x44,  0x37, 
+0x77,  0x78,  0x59,  0x43,  0x77,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x62,  0x38,  0x35,  0x31,  0x31,  0x65,  0x31, 
+0x64,  0x37,  0x34,  0x35,  0x34,  0x39,  0x65,  0x33, 
+0x30,  0x35,  0x35,  0x31,  0x37,  0x64,  0x34,  0x38, 
+0x61,  0x31,  0x64,  0x33,  0x39,  0x34,  0x64,  0x31, 
+0x62,  0x65,  0x32,  0x63,  0x66,  0x61,  0x35,  0x64, 
+0x30,  0x66,  0x33,  0x63,  0x30,  0x64,  0x38,  0x33, 
+0x66,  0x39,  0x66,  0x34,  0x35,  0x30,  0x33,  0x31, 
+0x36,  0x66,  0x66,  0x61,  0x30,  0x31,  0x32,  0x37, 
+0x36,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e, 
+0x22,  0x3a,  0x20,  0x22,  0x74,  0x65,  0x73,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65, 
+0x73,  0x73,  0x65,  0x64,  0x22,  0x3a,  0x20,  0x66, 
+0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69, 
+0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x54,  0x50,  0x6e, 
+0x61,  0x46,  0x35,  0x32,  0x78,  0x34,  0x77,  0x34, 
+0x54,  0x71,  0x36,  0x61,  0x66,  0x50,  0x78,  0x52, 
+0x48,  0x75,  0x78,  0x33,  0x77,  0x62,  0x59,  0x62, 
+0x38,  0x36,  0x74,  0x68,  0x53,  0x37,  0x53,  0x34, 
+0x35,  0x41,  0x37,  0x72,  0x33,  0x6f,  0x5a,  0x63, 
+0x31,  0x41,  0x48,  0x54,  0x51,  0x36,  0x51,  0x6d, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x61,  0x64,  0x36,  0x38, 
+0x63,  0x34,  0x38,  0x64,  0x33,  0x33,  0x37,  0x31, 
+0x38,  0x31,  0x64,  0x61,  0x31,  0x32,  0x35,  0x64, 
+0x65,  0x39,  0x30,  0x36,  0x31,  0x39,  0x33,  0x33, 
+0x65,  0x63,  0x65,  0x63,  0x63,  0x64,  0x66,  0x37, 
+0x64,  0x39,  0x31,  0x37,  0x36,  0x33,  0x31,  0x61, 
+0x66,  0x37,  0x64,  0x33,  0x34,  0x66,  0x37,  0x65, 
+0x33,  0x38,  0x30,  0x38,  0x32,  0x62,  0x66,  0x66, 
+0x39,  0x61,  0x31,  0x31,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68, 
+0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74, 
+0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x69,  0x73,  0x43,  0x6f,  0x6d, 
+0x70,  0x72,  0x65,  0x73,  0x73,  0x65,  0x64,  0x22, 
+0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x39,  0x32, 
+0x34,  0x55,  0x33,  0x35,  0x79,  0x46,  0x63,  0x59, 
+0x6b,  0x78,  0x65,  0x32,  0x4a,  0x58,  0x47,  0x6d, 
+0x75,  0x68,  0x53,  0x52,  0x56,  0x61,  0x53,  0x68, 
+0x47,  0x79,  0x68,  0x52,  0x44,  0x5a,  0x78,  0x31, 
+0x79,  0x73,  0x50,  0x6d,  0x77,  0x31,  0x73,  0x41, 
+0x48,  0x75,  0x73,  0x7a,  0x47,  0x4d,  0x6f,  0x78, 
+0x71,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x33,  0x65,  0x38, 
+0x64,  0x66,  0x61,  0x66,  0x37,  0x38,  0x64,  0x34, 
+0x66,  0x30,  0x32,  0x62,  0x31,  0x31,  0x64,  0x30, 
+0x62,  0x36,  0x34,  0x35,  0x36,  0x34,  0x38,  0x61, 
+0x34,  0x66,  0x33,  0x30,  0x38,  0x30,  0x64,  0x37, 
+0x31,  0x64,  0x30,  0x64,  0x30,  0x36,  0x38,  0x39, 
+0x37,  0x39,  0x63,  0x34,  0x37,  0x66,  0x37,  0x32, 
+0x35,  0x35,  0x63,  0x39,  0x61,  0x32,  0x39,  0x65, 
+0x65,  0x65,  0x30,  0x31,  0x64,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x73,  0x69,  0x67,  0x6e,  0x65,  0x74,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65,  0x73,  0x73, 
+0x65,  0x64,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x52,  0x79,  0x31,  0x71,  0x43, 
+0x66,  0x32,  0x4c,  0x55,  0x65,  0x73,  0x47,  0x50, 
+0x51,  0x61,  0x67,  0x54,  0x6b,  0x59,  0x77,  0x6b, 
+0x32,  0x56,  0x33,  0x50,  0x79,  0x4e,  0x32,  0x4b, 
+0x43,  0x50,  0x4b,  0x67,  0x78,  0x65,  0x67,  0x36, 
+0x6b,  0x36,  0x4b,  0x6f,  0x4a,  0x50,  0x7a,  0x48, 
+0x37,  0x6e,  0x72,  0x56,  0x6a,  0x77,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x38,  0x32,  0x64,  0x34,  0x31,  0x38, 
+0x37,  0x36,  0x39,  0x30,  0x64,  0x36,  0x62,  0x35, 
+0x39,  0x62,  0x63,  0x66,  0x66,  0x64,  0x61,  0x32, 
+0x37,  0x64,  0x61,  0x65,  0x35,  0x32,  0x66,  0x32, 
+0x65,  0x63,  0x62,  0x38,  0x37,  0x33,  0x31,  0x33, 
+0x63,  0x66,  0x63,  0x30,  0x39,  0x30,  0x34,  0x65, 
+0x30,  0x62,  0x36,  0x37,  0x34,  0x61,  0x32,  0x37, 
+0x64,  0x39,  0x30,  0x36,  0x61,  0x36,  0x35,  0x66, 
+0x64,  0x65,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x73,  0x69,  0x67, 
+0x6e,  0x65,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x69,  0x73,  0x43,  0x6f,  0x6d, 
+0x70,  0x72,  0x65,  0x73,  0x73,  0x65,  0x64,  0x22, 
+0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x39,  0x33, 
+0x32,  0x4e,  0x54,  0x63,  0x48,  0x4b,  0x33,  0x35, 
+0x41,  0x70,  0x66,  0x32,  0x43,  0x33,  0x4b,  0x39, 
+0x5a,  0x76,  0x31,  0x5a,  0x64,  0x65,  0x5a,  0x45, 
+0x6d,  0x42,  0x31,  0x78,  0x37,  0x5a,  0x54,  0x32, 
+0x4a,  0x75,  0x33,  0x53,  0x6a,  0x6f,  0x45,  0x59, 
+0x36,  0x70,  0x55,  0x67,  0x55,  0x70,  0x54,  0x37, 
+0x48,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x64,  0x37, 
+0x64,  0x62,  0x61,  0x32,  0x34,  0x64,  0x66,  0x39, 
+0x65,  0x30,  0x30,  0x33,  0x65,  0x31,  0x34,  0x35, 
+0x61,  0x65,  0x39,  0x62,  0x34,  0x38,  0x36,  0x32, 
+0x37,  0x37,  0x36,  0x34,  0x31,  0x33,  0x61,  0x30, 
+0x62,  0x62,  0x36,  0x66,  0x61,  0x35,  0x62,  0x34, 
+0x65,  0x34,  0x32,  0x37,  0x35,  0x33,  0x33,  0x39, 
+0x37,  0x66,  0x32,  0x64,  0x39,  0x35,  0x33,  0x36, 
+0x65,  0x35,  0x38,  0x61,  0x39,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x72,  0x65,  0x67,  0x74,  0x65,  0x73,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65,  0x73, 
+0x73,  0x65,  0x64,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x74,  0x72, 
+0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x4e,  0x61,  0x37,  0x35, 
+0x6f,  0x72,  0x59,  0x51,  0x32,  0x6f,  0x6f,  0x73, 
+0x35,  0x32,  0x7a,  0x43,  0x6e,  0x4d,  0x61,  0x53, 
+0x35,  0x50,  0x47,  0x36,  0x58,  0x62,  0x4e,  0x5a, 
+0x4b,  0x63,  0x35,  0x4c,  0x70,  0x47,  0x78,  0x54, 
+0x48,  0x61,  0x63,  0x72,  0x78,  0x77,  0x57,  0x65, 
+0x58,  0x34,  0x57,  0x41,  0x4b,  0x33,  0x45,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x31,  0x64,  0x38,  0x37,  0x65, 
+0x33,  0x63,  0x35,  0x38,  0x62,  0x30,  0x38,  0x37, 
+0x36,  0x36,  0x66,  0x65,  0x61,  0x30,  0x33,  0x35, 
+0x39,  0x38,  0x33,  0x38,  0x30,  0x65,  0x63,  0x38, 
+0x64,  0x35,  0x39,  0x66,  0x38,  0x63,  0x38,  0x38, 
+0x64,  0x35,  0x33,  0x39,  0x32,  0x62,  0x66,  0x36, 
+0x38,  0x33,  0x61,  0x62,  0x31,  0x30,  0x38,  0x38, 
+0x62,  0x64,  0x34,  0x63,  0x61,  0x66,  0x30,  0x37, 
+0x33,  0x65,  0x65,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72,  0x65, 
+0x67,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x43, 
+0x6f,  0x6d,  0x70,  0x72,  0x65,  0x73,  0x73,  0x65, 
+0x64,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x62,  0x63,  0x31,  0x71,  0x35,  0x63,  0x75,  0x61, 
+0x74,  0x79,  0x6e,  0x6a,  0x6d,  0x6b,  0x34,  0x73, 
+0x7a,  0x68,  0x34,  0x30,  0x6d,  0x6d,  0x75,  0x6e, 
+0x73,  0x7a,  0x66,  0x7a,  0x68,  0x37,  0x7a,  0x72, 
+0x63,  0x35,  0x78,  0x6d,  0x39,  0x77,  0x38,  0x63, 
+0x63,  0x79,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30,  0x30, 
+0x31,  0x34,  0x61,  0x36,  0x33,  0x39,  0x64,  0x35, 
+0x39,  0x32,  0x37,  0x32,  0x64,  0x64,  0x61,  0x62, 
+0x30,  0x31,  0x35,  0x65,  0x61,  0x66,  0x64,  0x65, 
+0x66,  0x39,  0x33,  0x38,  0x30,  0x39,  0x32,  0x32, 
+0x62,  0x66,  0x38,  0x34,  0x33,  0x63,  0x35,  0x30, 
+0x64,  0x62,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69, 
+0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x31,  0x71, 
+0x6b,  0x77,  0x37,  0x6c,  0x7a,  0x33,  0x61,  0x68, 
+0x6d,  0x73,  0x36,  0x65,  0x30,  0x61,  0x6a,  0x76, 
+0x32,  0x37,  0x6d,  0x7a,  0x68,  0x37,  0x67,  0x36, 
+0x32,  0x74,  0x63,  0x68,  0x6a,  0x70,  0x6d,  0x76, 
+0x65,  0x34,  0x61,  0x66,  0x63,  0x32,  0x39,  0x75, 
+0x37,  0x77,  0x34,  0x39,  0x74,  0x64,  0x64,  0x79, 
+0x64,  0x79,  0x32,  0x73,  0x79,  0x76,  0x30,  0x30, 
+0x38,  0x37,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30,  0x30, 
+0x32,  0x30,  0x62,  0x33,  0x62,  0x64,  0x66,  0x31, 
+0x34,  0x37,  0x62,  0x37,  0x64,  0x63,  0x33,  0x35, 
+0x39,  0x37,  0x66,  0x36,  0x34,  0x63,  0x35,  0x37, 
+0x62,  0x36,  0x32,  0x62,  0x66,  0x39,  0x31,  0x61, 
+0x35,  0x32,  0x66,  0x31,  0x37,  0x39,  0x30,  0x37, 
+0x36,  0x63,  0x63,  0x64,  0x37,  0x61,  0x39,  0x63, 
+0x32,  0x38,  0x62,  0x63,  0x66,  0x33,  0x61,  0x61, 
+0x35,  0x35,  0x62,  0x35,  0x61,  0x34,  0x36,  0x39, 
+0x31,  0x35,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69, 
+0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x31,  0x70, 
+0x35,  0x72,  0x67,  0x76,  0x71,  0x65,  0x6a,  0x71, 
+0x68,  0x39,  0x64,  0x68,  0x33,  0x37,  0x74,  0x39, 
+0x67,  0x39,  0x34,  0x64,  0x64,  0x39,  0x63,  0x6d, 
+0x38,  0x76,  0x74,  0x71,  0x6e,  0x73,  0x37,  0x64, 
+0x6e,  0x64,  0x67,  0x6a,  0x34,  0x32,  0x33,  0x65, 
+0x67,  0x77,  0x67,  0x67,  0x73,  0x67,  0x67,  0x63, 
+0x64,  0x7a,  0x6d,  0x73,  0x73,  0x70,  0x76,  0x72, 
+0x37,  0x6a,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x31, 
+0x32,  0x30,  0x61,  0x30,  0x64,  0x30,  0x63,  0x30, 
+0x36,  0x36,  0x34,  0x30,  0x62,  0x39,  0x35,  0x62, 
+0x37,  0x38,  0x66,  0x39,  0x36,  0x35,  0x34,  0x31, 
+0x36,  0x61,  0x64,  0x36,  0x39,  0x37,  0x31,  0x62, 
+0x33,  0x62,  0x31,  0x36,  0x30,  0x39,  0x63,  0x33, 
+0x63,  0x64,  0x39,  0x62,  0x35,  0x31,  0x32,  0x61, 
+0x61,  0x61,  0x33,  0x39,  0x34,  0x33,  0x39,  0x30, 
+0x38,  0x38,  0x32,  0x31,  0x31,  0x38,  0x36,  0x38, 
+0x62,  0x37,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69, 
+0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x31,  0x7a, 
+0x72,  0x34,  0x70,  0x71,  0x36,  0x33,  0x75,  0x64, 
+0x63,  0x6b,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x32, 
+0x30,  0x32,  0x31,  0x64,  0x34,  0x32,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x6d,  0x61,  0x69,  0x6e,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x72,  0x79, 
+0x43,  0x61,  0x73,  0x65,  0x46,  0x6c,  0x69,  0x70, 
+0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x74,  0x62,  0x31,  0x71,  0x37,  0x34,  0x66,  0x78, 
+0x77,  0x6e,  0x76,  0x68,  0x73,  0x75,  0x65,  0x30, 
+0x6c,  0x38,  0x77,  0x72,  0x65,  0x6d,  0x67,  0x71, 
+0x36,  0x36,  0x78,  0x7a,  0x76,  0x6e,  0x34,  0x38, 
+0x6a,  0x6c,  0x63,  0x35,  0x7a,  0x74,  0x68,  0x73, 
+0x76,  0x7a,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30,  0x30, 
+0x31,  0x34,  0x66,  0x35,  0x35,  0x32,  0x36,  0x37, 
+0x34,  0x64,  0x39,  0x37,  0x38,  0x37,  0x33,  0x32, 
+0x66,  0x66,  0x39,  0x64,  0x63,  0x33,  0x63,  0x65, 
+0x64,  0x30,  0x30,  0x64,  0x36,  0x38,  0x63,  0x32, 
+0x36,  0x34,  0x65,  0x61,  0x37,  0x39,  0x37,  0x66, 
+0x31,  0x34,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74,  0x65,  0x73, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31,  0x71, 
+0x70,  0x74,  0x37,  0x63,  0x71,  0x67,  0x71,  0x38, 
+0x75,  0x6b,  0x76,  0x39,  0x32,  0x64,  0x63,  0x72, 
+0x61,  0x75,  0x6e,  0x39,  0x63,  0x33,  0x6e,  0x30, 
+0x73,  0x33,  0x61,  0x73,  0x77,  0x72,  0x74,  0x36, 
+0x32,  0x76,  0x74,  0x76,  0x38,  0x6e,  0x71,  0x6d, 
+0x6b,  0x66,  0x70,  0x61,  0x32,  0x74,  0x6a,  0x66, 
+0x67,  0x68,  0x65,  0x73,  0x76,  0x39,  0x6c,  0x6e, 
+0x37,  0x34,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30,  0x30, 
+0x32,  0x30,  0x30,  0x61,  0x66,  0x64,  0x38,  0x30, 
+0x32,  0x30,  0x30,  0x37,  0x65,  0x35,  0x39,  0x38, 
+0x35,  0x35,  0x33,  0x37,  0x30,  0x33,  0x65,  0x66, 
+0x32,  0x36,  0x35,  0x63,  0x34,  0x36,  0x36,  0x66, 
+0x38,  0x34,  0x37,  0x62,  0x30,  0x37,  0x30,  0x64, 
+0x37,  0x61,  0x35,  0x33,  0x31,  0x36,  0x63,  0x33, 
+0x63,  0x63,  0x31,  0x62,  0x62,  0x32,  0x34,  0x33, 
+0x64,  0x35,  0x32,  0x65,  0x34,  0x39,  0x34,  0x35, 
+0x66,  0x33,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74,  0x65,  0x73, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31,  0x70, 
+0x68,  0x39,  0x76,  0x33,  0x65,  0x38,  0x6e,  0x78, 
+0x63,  0x74,  0x35,  0x37,  0x68,  0x6b,  0x6e,  0x6c, 
+0x6b,  0x68,  0x6b,  0x7a,  0x37,  0x35,  0x70,  0x35, 
+0x70,  0x6e,  0x78,  0x6e,  0x6b,  0x6e,  0x30,  0x35, 
+0x63,  0x77,  0x38,  0x65,  0x77,  0x70,  0x78,  0x75, 
+0x36,  0x74,  0x65,  0x6b,  0x35,  0x36,  0x67,  0x32, 
+0x39,  0x78,  0x67,  0x71,  0x79,  0x64,  0x7a,  0x66, 
+0x75,  0x37,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x31, 
+0x32,  0x30,  0x62,  0x39,  0x35,  0x39,  0x31,  0x63, 
+0x39,  0x65,  0x36,  0x36,  0x63,  0x32,  0x65,  0x39, 
+0x65,  0x62,  0x64,  0x61,  0x37,  0x66,  0x62,  0x35, 
+0x65,  0x63,  0x32,  0x66,  0x35,  0x30,  0x33,  0x34, 
+0x30,  0x63,  0x63,  0x64,  0x33,  0x62,  0x34,  0x64, 
+0x66,  0x34,  0x63,  0x33,  0x38,  0x66,  0x39,  0x37, 
+0x30,  0x34,  0x64,  0x63,  0x64,  0x32,  0x66,  0x33, 
+0x36,  0x61,  0x36,  0x39,  0x30,  0x61,  0x32,  0x39, 
+0x39,  0x30,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74,  0x65,  0x73, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31,  0x72, 
+0x61,  0x79,  0x36,  0x65,  0x38,  0x67,  0x78,  0x66, 
+0x78,  0x34,  0x39,  0x65,  0x72,  0x73,  0x36,  0x63, 
+0x34,  0x63,  0x37,  0x30,  0x6c,  0x33,  0x63,  0x38, 
+0x6c,  0x73,  0x78,  0x74,  0x63,  0x6d,  0x6c,  0x78, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x35,  0x33,  0x31,  0x30, 
+0x65,  0x39,  0x33,  0x35,  0x39,  0x33,  0x61,  0x30, 
+0x63,  0x39,  0x33,  0x35,  0x34,  0x62,  0x39,  0x31, 
+0x63,  0x33,  0x35,  0x38,  0x61,  0x65,  0x33,  0x63, 
+0x66,  0x66,  0x63,  0x37,  0x30,  0x37,  0x66,  0x63, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x74,  0x65,  0x73,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x74, 
+0x72,  0x79,  0x43,  0x61,  0x73,  0x65,  0x46,  0x6c, 
+0x69,  0x70,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x62,  0x31,  0x71,  0x30,  0x73, 
+0x71,  0x7a,  0x66,  0x70,  0x33,  0x7a,  0x6a,  0x34, 
+0x32,  0x75,  0x30,  0x70,  0x65,  0x72,  0x78,  0x72, 
+0x36,  0x6a,  0x61,  0x68,  0x68,  0x75,  0x34,  0x79, 
+0x30,  0x33,  0x75,  0x77,  0x34,  0x64,  0x79,  0x70, 
+0x6b,  0x36,  0x73,  0x63,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x30,  0x30,  0x31,  0x34,  0x37,  0x63,  0x30,  0x30, 
+0x32,  0x34,  0x38,  0x36,  0x32,  0x32,  0x39,  0x35, 
+0x35,  0x35,  0x63,  0x37,  0x38,  0x37,  0x32,  0x33, 
+0x33,  0x30,  0x66,  0x35,  0x32,  0x65,  0x64,  0x65, 
+0x66,  0x63,  0x61,  0x39,  0x31,  0x66,  0x31,  0x65, 
+0x33,  0x61,  0x61,  0x64,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68, 
+0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x73, 
+0x69,  0x67,  0x6e,  0x65,  0x74,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x72,  0x79, 
+0x43,  0x61,  0x73,  0x65,  0x46,  0x6c,  0x69,  0x70, 
+0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x74,  0x62,  0x31,  0x71,  0x39,  0x6a,  0x76,  0x34, 
+0x71,  0x6e,  0x61,  0x77,  0x6e,  0x75,  0x65,  0x76, 
+0x71,  0x61,  0x65,  0x61,  0x64,  0x6e,  0x34,  0x37, 
+0x67,  0x6b,  0x71,  0x30,  0x35,  0x65,  0x76,  0x37, 
+0x38,  0x6d,  0x34,  0x71,  0x67,  0x33,  0x7a,  0x71, 
+0x65,  0x6a,  0x79,  0x6b,  0x64,  0x72,  0x39,  0x75, 
+0x30,  0x63,  0x6d,  0x37,  0x79,  0x75,  0x74,  0x71, 
+0x36,  0x67,  0x75,  0x35,  0x64,  0x6a,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x30,  0x30,  0x32,  0x30,  0x32,  0x63, 
+0x39,  0x39,  0x35,  0x30,  0x34,  0x66,  0x61,  0x65, 
+0x39,  0x66,  0x33,  0x32,  0x63,  0x30,  0x37,  0x37, 
+0x33,  0x64,  0x36,  0x63,  0x65,  0x62,  0x65,  0x34, 
+0x35,  0x38,  0x30,  0x66,  0x61,  0x36,  0x35,  0x39, 
+0x65,  0x33,  0x65,  0x65,  0x61,  0x30,  0x34,  0x34, 
+0x34,  0x34,  0x30,  0x63,  0x63,  0x38,  0x39,  0x36, 
+0x36,  0x38,  0x63,  0x62,  0x63,  0x37,  0x65,  0x33, 
+0x37,  0x65,  0x32,  0x37,  0x31,  0x36,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x73,  0x69,  0x67,  0x6e,  0x65,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x74, 
+0x72,  0x79,  0x43,  0x61,  0x73,  0x65,  0x46,  0x6c, 
+0x69,  0x70,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x62,  0x31,  0x70,  0x78,  0x71, 
+0x66,  0x37,  0x64,  0x38,  0x32,  0x35,  0x77,  0x6a, 
+0x74,  0x63,  0x66,  0x74,  0x6a,  0x37,  0x75,  0x65, 
+0x70,  0x38,  0x77,  0x32,  0x34,  0x6a,  0x71,  0x33, 
+0x74,  0x7a,  0x38,  0x76,  0x75,  0x64,  0x66,  0x61, 
+0x71,  0x6a,  0x32,  0x30,  0x72,  0x6e,  0x73,  0x38, 
+0x61,  0x68,  0x71,  0x79,  0x61,  0x35,  0x36,  0x67, 
+0x63,  0x73,  0x39,  0x32,  0x65,  0x71,  0x74,  0x75, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x35,  0x31,  0x32,  0x30, 
+0x33,  0x30,  0x31,  0x33,  0x65,  0x36,  0x39,  0x64, 
+0x35,  0x34,  0x37,  0x34,  0x39,  0x37,  0x38,  0x34, 
+0x61,  0x65,  0x35,  0x65,  0x65,  0x36,  0x34,  0x32, 
+0x37,  0x37,  0x32,  0x61,  0x62,  0x32,  0x30,  0x34, 
+0x35,  0x36,  0x32,  0x33,  0x62,  0x33,  0x38,  0x64, 
+0x34,  0x66,  0x34,  0x31,  0x32,  0x35,  0x33,  0x63, 
+0x37,  0x33,  0x38,  0x31,  0x66,  0x62,  0x37,  0x30, 
+0x31,  0x33,  0x62,  0x34,  0x64,  0x32,  0x33,  0x31, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x73,  0x69,  0x67,  0x6e,  0x65, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31,  0x72, 
+0x73,  0x72,  0x7a,  0x6b,  0x79,  0x76,  0x75,  0x32, 
+0x72,  0x74,  0x30,  0x64,  0x63,  0x67,  0x65,  0x78, 
+0x61,  0x6a,  0x74,  0x61,  0x7a,  0x6c,  0x77,  0x35, 
+0x6e,  0x66,  0x74,  0x34,  0x6a,  0x37,  0x34,  0x39, 
+0x34,  0x61,  0x79,  0x33,  0x39,  0x36,  0x71,  0x36, 
+0x61,  0x75,  0x77,  0x39,  0x33,  0x37,  0x35,  0x77, 
+0x78,  0x73,  0x72,  0x73,  0x67,  0x61,  0x67,  0x38, 
+0x38,  0x34,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x33, 
+0x32,  0x30,  0x38,  0x30,  0x63,  0x35,  0x36,  0x32, 
+0x33,  0x33,  0x38,  0x61,  0x31,  0x61,  0x64,  0x65, 
+0x64,  0x63,  0x32,  0x33,  0x32,  0x36,  0x65,  0x63, 
+0x39,  0x37,  0x64,  0x31,  0x37,  0x64,  0x64,  0x34, 
+0x39,  0x61,  0x35,  0x37,  0x35,  0x39,  0x37,  0x61, 
+0x61,  0x35,  0x61,  0x66,  0x34,  0x39,  0x31,  0x32, 
+0x65,  0x38,  0x31,  0x61,  0x65,  0x66,  0x31,  0x63, 
+0x35,  0x38,  0x66,  0x61,  0x38,  0x65,  0x33,  0x34, 
+0x30,  0x37,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x73,  0x69,  0x67, 
+0x6e,  0x65,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69, 
+0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66, 
+0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61, 
+0x73,  0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a, 
+0x20,  0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x63, 
+0x72,  0x74,  0x31,  0x71,  0x77,  0x66,  0x35,  0x32, 
+0x64,  0x74,  0x39,  0x79,  0x32,  0x73,  0x76,  0x30, 
+0x66,  0x37,  0x66,  0x77,  0x6b,  0x63,  0x70,  0x6d, 
+0x74,  0x66,  0x6a,  0x66,  0x37,  0x34,  0x64,  0x34, 
+0x6e,  0x70,  0x32,  0x73,  0x61,  0x65,  0x6c,  0x6a, 
+0x74,  0x36,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30,  0x30, 
+0x31,  0x34,  0x37,  0x32,  0x36,  0x38,  0x61,  0x36, 
+0x61,  0x63,  0x61,  0x34,  0x35,  0x34,  0x31,  0x38, 
+0x66,  0x34,  0x66,  0x39,  0x32,  0x65,  0x62,  0x36, 
+0x30,  0x33,  0x62,  0x35,  0x61,  0x36,  0x34,  0x39, 
+0x66,  0x35,  0x35,  0x62,  0x35,  0x39,  0x38,  0x35, 
+0x35,  0x30,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72,  0x65,  0x67, 
+0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72, 
+0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20, 
+0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x74,  0x72,  0x79,  0x43, 
+0x61,  0x73,  0x65,  0x46,  0x6c,  0x69,  0x70,  0x22, 
+0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x62, 
+0x63,  0x72,  0x74,  0x31,  0x71,  0x30,  0x6c,  0x6d, 
+0x61,  0x38,  0x34,  0x75,  0x6e,  0x79,  0x63,  0x78, 
+0x6c,  0x34,  0x6e,  0x39,  0x36,  0x65,  0x74,  0x66, 
+0x66,  0x74,  0x68,  0x71,  0x6c,  0x66,  0x37,  0x79, 
+0x35,  0x61,  0x78,  0x79,  0x70,  0x34,  0x66,  0x78, 
+0x66,  0x36,  0x34,  0x6b,  0x6d,  0x68,  0x79,  0x6d, 
+0x76,  0x77,  0x38,  0x6c,  0x36,  0x70,  0x77,  0x66, 
+0x73,  0x33,  0x39,  0x66,  0x75,  0x74,  0x64,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x30,  0x30,  0x32,  0x30,  0x37, 
+0x66,  0x66,  0x37,  0x64,  0x33,  0x64,  0x37,  0x39, 
+0x33,  0x32,  0x36,  0x30,  0x64,  0x66,  0x61,  0x63, 
+0x63,  0x62,  0x61,  0x63,  0x61,  0x64,  0x32,  0x39, 
+0x35,  0x64,  0x63,  0x31,  0x66,  0x34,  0x66,  0x38, 
+0x39,  0x34,  0x65,  0x39,  0x38,  0x38,  0x31,  0x61, 
+0x61,  0x34,  0x63,  0x39,  0x64,  0x35,  0x36,  0x64, 
+0x62,  0x62,  0x39,  0x33,  0x36,  0x63,  0x37,  0x31, 
+0x66,  0x66,  0x61,  0x30,  0x62,  0x39,  0x33,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x72,  0x65,  0x67,  0x74,  0x65,  0x73, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65, 
+0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x72,  0x74, 
+0x31,  0x70,  0x33,  0x78,  0x61,  0x74,  0x32,  0x72, 
+0x79,  0x75,  0x63,  0x63,  0x32,  0x76,  0x30,  0x61, 
+0x64,  0x72,  0x6b,  0x74,  0x71,  0x6e,  0x61,  0x76, 
+0x66,  0x7a,  0x74,  0x74,  0x76,  0x65,  0x7a,  0x72, 
+0x72,  0x32,  0x37,  0x6e,  0x67,  0x6c,  0x74,  0x73, 
+0x61,  0x32,  0x37,  0x32,  0x36,  0x70,  0x32,  0x65, 
+0x68,  0x76,  0x78,  0x7a,  0x34,  0x73,  0x65,  0x37, 
+0x32,  0x32,  0x76,  0x32,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x35,  0x31,  0x32,  0x30,  0x38,  0x39,  0x62,  0x61, 
+0x62,  0x35,  0x30,  0x63,  0x39,  0x63,  0x63,  0x36, 
+0x31,  0x34,  0x63,  0x37,  0x66,  0x35,  0x61,  0x33, 
+0x62,  0x32,  0x63,  0x31,  0x33,  0x65,  0x62,  0x31, 
+0x32,  0x32,  0x35,  0x61,  0x64,  0x39,  0x39,  0x31, 
+0x30,  0x63,  0x36,  0x61,  0x66,  0x34,  0x64,  0x31, 
+0x66,  0x35,  0x63,  0x33,  0x61,  0x61,  0x66,  0x32, 
+0x62,  0x34,  0x31,  0x35,  0x36,  0x36,  0x65,  0x63, 
+0x33,  0x30,  0x61,  0x62,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68, 
+0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72, 
+0x65,  0x67,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x72, 
+0x79,  0x43,  0x61,  0x73,  0x65,  0x46,  0x6c,  0x69, 
+0x70,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x62,  0x63,  0x72,  0x74,  0x31,  0x73,  0x61, 
+0x66,  0x6c,  0x79,  0x64,  0x77,  0x36,  0x65,  0x32, 
+0x36,  0x78,  0x68,  0x70,  0x32,  0x39,  0x65,  0x75, 
+0x68,  0x79,  0x35,  0x6a,  0x6b,  0x65,  0x35,  0x6a, 
+0x6a,  0x71,  0x79,  0x79,  0x77,  0x6b,  0x33,  0x77, 
+0x76,  0x74,  0x63,  0x39,  0x75,  0x6c,  0x67,  0x77, 
+0x39,  0x64,  0x76,  0x78,  0x79,  0x75,  0x71,  0x79, 
+0x39,  0x68,  0x64,  0x6e,  0x78,  0x74,  0x68,  0x79, 
+0x77,  0x37,  0x35,  0x35,  0x63,  0x37,  0x6c,  0x64, 
+0x61,  0x76,  0x79,  0x37,  0x75,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x36,  0x30,  0x32,  0x38,  0x65,  0x61,  0x37, 
+0x65,  0x34,  0x36,  0x62,  0x62,  0x35,  0x39,  0x35, 
+0x36,  0x38,  0x64,  0x37,  0x30,  0x61,  0x38,  0x62, 
+0x39,  0x65,  0x35,  0x63,  0x39,  0x34,  0x39,  0x35, 
+0x62,  0x33,  0x34,  0x39,  0x34,  0x38,  0x30,  0x34, 
+0x32,  0x33,  0x61,  0x64,  0x31,  0x37,  0x33,  0x31, 
+0x37,  0x38,  0x32,  0x66,  0x33,  0x65,  0x38,  0x37, 
+0x31,  0x35,  0x61,  0x63,  0x33,  0x31,  0x33,  0x38, 
+0x30,  0x32,  0x31,  0x36,  0x65,  0x64,  0x39,  0x39, 
+0x39,  0x37,  0x37,  0x32,  0x33,  0x62,  0x64,  0x34, 
+0x61,  0x36,  0x33,  0x64,  0x66,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x72,  0x65,  0x67,  0x74,  0x65,  0x73,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x74, 
+0x72,  0x79,  0x43,  0x61,  0x73,  0x65,  0x46,  0x6c, 
+0x69,  0x70,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x31,  0x36,  0x79,  0x33,  0x51,  0x31, 
+0x58,  0x56,  0x52,  0x5a,  0x71,  0x4d,  0x52,  0x39, 
+0x54,  0x31,  0x58,  0x4c,  0x31,  0x46,  0x6b,  0x76, 
+0x4e,  0x74,  0x44,  0x32,  0x45,  0x31,  0x62,  0x58, 
+0x42,  0x75,  0x59,  0x61,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x37,  0x36,  0x61,  0x39,  0x31,  0x34,  0x34,  0x31, 
+0x37,  0x31,  0x65,  0x63,  0x36,  0x37,  0x33,  0x61, 
+0x65,  0x62,  0x39,  0x66,  0x63,  0x66,  0x34,  0x32, 
+0x61,  0x66,  0x36,  0x30,  0x39,  0x34,  0x61,  0x33, 
+0x63,  0x38,  0x32,  0x32,  0x30,  0x37,  0x65,  0x33, 
+0x62,  0x39,  0x61,  0x37,  0x38,  0x31,  0x38,  0x38, 
+0x61,  0x63,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69, 
+0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x33,  0x43,  0x6d,  0x5a,  0x5a, 
+0x6e,  0x41,  0x69,  0x48,  0x56,  0x51,  0x67,  0x69, 
+0x41,  0x4b,  0x53,  0x61,  0x6b,  0x66,  0x38,  0x36, 
+0x34,  0x6f,  0x4a,  0x4d,  0x78,  0x4e,  0x32,  0x42, 
+0x50,  0x31,  0x65,  0x4c,  0x43,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x61,  0x39,  0x31,  0x34,  0x37,  0x39,  0x38, 
+0x35,  0x37,  0x35,  0x66,  0x63,  0x31,  0x30,  0x34, 
+0x31,  0x62,  0x39,  0x34,  0x34,  0x30,  0x63,  0x34, 
+0x65,  0x36,  0x33,  0x63,  0x32,  0x38,  0x65,  0x35, 
+0x37,  0x65,  0x35,  0x39,  0x37,  0x64,  0x30,  0x30, 
+0x62,  0x37,  0x65,  0x34,  0x33,  0x38,  0x37,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x6d,  0x61,  0x69,  0x6e,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x6d,  0x74,  0x43,  0x42,  0x33,  0x53,  0x6f,  0x42, 
+0x6f,  0x37,  0x45,  0x59,  0x55,  0x76,  0x38,  0x6a, 
+0x35,  0x34,  0x6b,  0x55,  0x75,  0x62,  0x47,  0x59, 
+0x34,  0x78,  0x33,  0x61,  0x4a,  0x50,  0x59,  0x38, 
+0x6e,  0x6b,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x37,  0x36, 
+0x61,  0x39,  0x31,  0x34,  0x38,  0x62,  0x30,  0x63, 
+0x35,  0x66,  0x39,  0x65,  0x65,  0x37,  0x31,  0x34, 
+0x65,  0x30,  0x64,  0x31,  0x64,  0x32,  0x34,  0x36, 
+0x34,  0x32,  0x61,  0x64,  0x36,  0x33,  0x64,  0x39, 
+0x64,  0x35,  0x66,  0x33,  0x39,  0x38,  0x64,  0x39, 
+0x62,  0x35,  0x36,  0x35,  0x38,  0x38,  0x61,  0x63, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x74,  0x65,  0x73,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x32,  0x4e,  0x35,  0x79,  0x6d,  0x7a,  0x7a, 
+0x4b,  0x70,  0x78,  0x36,  0x45,  0x64,  0x55,  0x52, 
+0x34,  0x55,  0x64,  0x4d,  0x5a,  0x37,  0x74,  0x39, 
+0x68,  0x63,  0x75,  0x77,  0x71,  0x74,  0x70,  0x48, 
+0x77,  0x67,  0x77,  0x35,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x61,  0x39,  0x31,  0x34,  0x38,  0x62,  0x61,  0x64, 
+0x62,  0x33,  0x63,  0x33,  0x62,  0x35,  0x63,  0x30, 
+0x64,  0x33,  0x39,  0x66,  0x39,  0x30,  0x36,  0x66, 
+0x37,  0x36,  0x31,  0x38,  0x65,  0x30,  0x30,  0x31, 
+0x38,  0x62,  0x37,  0x65,  0x61,  0x65,  0x34,  0x62, 
+0x61,  0x66,  0x37,  0x33,  0x38,  0x37,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x6d, 
+0x79,  0x58,  0x6e,  0x70,  0x59,  0x62,  0x75,  0x62, 
+0x32,  0x38,  0x7a,  0x67,  0x69,  0x4a,  0x75,  0x70, 
+0x44,  0x64,  0x5a,  0x53,  0x57,  0x5a,  0x74,  0x44, 
+0x62,  0x6a,  0x63,  0x79,  0x66,  0x4a,  0x56,  0x62, 
+0x79,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x37,  0x36,  0x61, 
+0x39,  0x31,  0x34,  0x63,  0x35,  0x39,  0x61,  0x63, 
+0x35,  0x37,  0x36,  0x36,  0x31,  0x62,  0x35,  0x37, 
+0x64,  0x61,  0x61,  0x64,  0x64,  0x37,  0x63,  0x30, 
+0x63,  0x61,  0x66,  0x37,  0x33,  0x31,  0x38,  0x63, 
+0x31,  0x34,  0x66,  0x35,  0x34,  0x63,  0x36,  0x63, 
+0x30,  0x66,  0x61,  0x38,  0x38,  0x61,  0x63,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x73,  0x69,  0x67,  0x6e,  0x65,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x32,  0x4d,  0x74,  0x4c,  0x67,  0x38, 
+0x6a,  0x53,  0x35,  0x6a,  0x53,  0x58,  0x6d,  0x39, 
+0x65,  0x76,  0x4d,  0x7a,  0x54,  0x74,  0x76,  0x70, 
+0x4c,  0x6a,  0x79,  0x32,  0x36,  0x64,  0x42,  0x6d, 
+0x6a,  0x46,  0x45,  0x6f,  0x54,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x61,  0x39,  0x31,  0x34,  0x30,  0x63,  0x30, 
+0x30,  0x30,  0x37,  0x65,  0x38,  0x39,  0x63,  0x65, 
+0x61,  0x36,  0x32,  0x35,  0x64,  0x33,  0x62,  0x66, 
+0x39,  0x35,  0x34,  0x33,  0x62,  0x61,  0x61,  0x35, 
+0x61,  0x34,  0x37,  0x30,  0x62,  0x62,  0x37,  0x65, 
+0x35,  0x62,  0x36,  0x37,  0x32,  0x38,  0x37,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x73,  0x69,  0x67,  0x6e,  0x65,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x6d,  0x7a,  0x43,  0x79,  0x71,  0x64, 
+0x66,  0x32,  0x55,  0x4e,  0x47,  0x64,  0x70,  0x67, 
+0x6b,  0x44,  0x39,  0x4e,  0x42,  0x67,  0x4c,  0x63, 
+0x78,  0x64,  0x77,  0x58,  0x52,  0x67,  0x31,  0x69, 
+0x39,  0x62,  0x75,  0x59,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x37,  0x36,  0x61,  0x39,  0x31,  0x34,  0x63,  0x64, 
+0x30,  0x34,  0x33,  0x31,  0x31,  0x62,  0x64,  0x64, 
+0x31,  0x65,  0x66,  0x39,  0x63,  0x35,  0x63,  0x32, 
+0x34,  0x65,  0x34,  0x31,  0x39,  0x33,  0x30,  0x65, 
+0x30,  0x33,  0x32,  0x61,  0x61,  0x64,  0x65,  0x38, 
+0x32,  0x61,  0x38,  0x36,  0x33,  0x61,  0x38,  0x38, 
+0x61,  0x63,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72,  0x65,  0x67, 
+0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72, 
+0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20, 
+0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x32,  0x4e, 
+0x33,  0x7a,  0x47,  0x69,  0x77,  0x46,  0x6b,  0x75, 
+0x32,  0x76,  0x51,  0x6a,  0x59,  0x6e,  0x41,  0x71, 
+0x58,  0x76,  0x35,  0x51,  0x75,  0x32,  0x7a,  0x74, 
+0x66,  0x59,  0x52,  0x68,  0x68,  0x37,  0x74,  0x62, 
+0x46,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x61,  0x39,  0x31, 
+0x34,  0x37,  0x35,  0x64,  0x35,  0x36,  0x64,  0x37, 
+0x35,  0x63,  0x38,  0x38,  0x65,  0x37,  0x30,  0x34, 
+0x64,  0x36,  0x63,  0x37,  0x32,  0x66,  0x62,  0x65, 
+0x38,  0x34,  0x61,  0x63,  0x31,  0x35,  0x30,  0x35, 
+0x61,  0x62,  0x66,  0x37,  0x33,  0x36,  0x62,  0x34, 
+0x30,  0x38,  0x37,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72,  0x65, 
+0x67,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35, 
+0x4a,  0x55,  0x48,  0x43,  0x67,  0x79,  0x78,  0x4e, 
+0x53,  0x48,  0x67,  0x36,  0x34,  0x77,  0x77,  0x6a, 
+0x75,  0x37,  0x32,  0x65,  0x4e,  0x73,  0x47,  0x36, 
+0x61,  0x6a,  0x71,  0x6f,  0x34,  0x5a,  0x32,  0x66, 
+0x48,  0x48,  0x77,  0x39,  0x69,  0x4c,  0x44,  0x4c, 
+0x66,  0x68,  0x36,  0x39,  0x72,  0x53,  0x69,  0x4c, 
+0x37,  0x77,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x36, 
+0x34,  0x34,  0x64,  0x30,  0x36,  0x64,  0x38,  0x38, 
+0x38,  0x35,  0x35,  0x64,  0x61,  0x63,  0x66,  0x33, 
+0x31,  0x39,  0x32,  0x61,  0x33,  0x31,  0x64,  0x66, 
+0x38,  0x66,  0x34,  0x61,  0x63,  0x64,  0x38,  0x65, 
+0x34,  0x63,  0x31,  0x35,  0x35,  0x63,  0x35,  0x32, 
+0x61,  0x38,  0x36,  0x64,  0x32,  0x63,  0x31,  0x66, 
+0x61,  0x34,  0x38,  0x33,  0x30,  0x33,  0x66,  0x35, 
+0x63,  0x66,  0x66,  0x30,  0x35,  0x33,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x6d,  0x61,  0x69,  0x6e,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x43, 
+0x6f,  0x6d,  0x70,  0x72,  0x65,  0x73,  0x73,  0x65, 
+0x64,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x4c,  0x32,  0x6b,  0x5a,  0x61,  0x65,  0x78, 
+0x47,  0x36,  0x39,  0x56,  0x53,  0x72,  0x69,  0x4d, 
+0x65,  0x39,  0x54,  0x32,  0x6d,  0x31,  0x6a,  0x6b, 
+0x53,  0x38,  0x36,  0x69,  0x50,  0x65,  0x33,  0x78, 
+0x4e,  0x62,  0x6a,  0x63,  0x64,  0x66,  0x61,  0x6b, 
+0x52,  0x43,  0x31,  0x50,  0x48,  0x65,  0x37,  0x61, 
+0x79,  0x37,  0x38,  0x4a,  0x69,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x61,  0x35,  0x30,  0x65,  0x65,  0x39,  0x34, 
+0x61,  0x65,  0x66,  0x63,  0x61,  0x62,  0x66,  0x35, 
+0x61,  0x35,  0x64,  0x37,  0x63,  0x38,  0x35,  0x62, 
+0x65,  0x35,  0x62,  0x33,  0x38,  0x34,  0x34,  0x64, 
+0x65,  0x65,  0x30,  0x33,  0x63,  0x35,  0x36,  0x30, 
+0x34,  0x38,  0x36,  0x31,  0x64,  0x62,  0x66,  0x63, 
+0x37,  0x37,  0x66,  0x65,  0x33,  0x38,  0x38,  0x63, 
+0x39,  0x31,  0x65,  0x35,  0x61,  0x33,  0x30,  0x66, 
+0x38,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e, 
+0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69,  0x6e, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65, 
+0x73,  0x73,  0x65,  0x64,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x74,  0x72, 
+0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x39,  0x32,  0x37,  0x4a,  0x77, 
+0x54,  0x31,  0x56,  0x69,  0x43,  0x72,  0x35,  0x54, 
+0x44,  0x32,  0x5a,  0x58,  0x38,  0x43,  0x73,  0x4d, 
+0x4e,  0x68,  0x67,  0x31,  0x37,  0x64,  0x58,  0x6d, 
+0x6f,  0x75,  0x35,  0x78,  0x75,  0x34,  0x79,  0x32, 
+0x4b,  0x69,  0x48,  0x35,  0x34,  0x7a,  0x44,  0x37, 
+0x69,  0x33,  0x34,  0x55,  0x4a,  0x71,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x34,  0x35,  0x30,  0x32,  0x61,  0x35, 
+0x34,  0x63,  0x30,  0x30,  0x32,  0x36,  0x62,  0x30, 
+0x31,  0x35,  0x30,  0x32,  0x38,  0x31,  0x64,  0x34, 
+0x31,  0x66,  0x34,  0x30,  0x38,  0x36,  0x30,  0x64, 
+0x31,  0x65,  0x32,  0x33,  0x38,  0x37,  0x30,  0x63, 
+0x36,  0x33,  0x63,  0x64,  0x63,  0x33,  0x32,  0x36, 
+0x34,  0x35,  0x62,  0x62,  0x65,  0x64,  0x36,  0x38, 
+0x38,  0x66,  0x32,  0x65,  0x65,  0x34,  0x31,  0x66, 
+0x36,  0x34,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69, 
+0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74,  0x65,  0x73, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x43,  0x6f,  0x6d,  0x70,  0x72, 
+0x65,  0x73,  0x73,  0x65,  0x64,  0x22,  0x3a,  0x20, 
+0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72, 
+0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x54,  0x70, 
+0x47,  0x47,  0x4e,  0x50,  0x56,  0x79,  0x32,  0x45, 
+0x61,  0x67,  0x61,  0x77,  0x6f,  0x68,  0x62,  0x72, 
+0x34,  0x61,  0x47,  0x74,  0x52,  0x4a,  0x7a,  0x70, 
+0x4c,  0x6e,  0x6a,  0x78,  0x47,  0x73,  0x47,  0x59, 
+0x68,  0x39,  0x44,  0x55,  0x63,  0x42,  0x4d,  0x34, 
+0x35,  0x66,  0x33,  0x4b,  0x64,  0x4b,  0x47,  0x46, 
+0x36,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x61,  0x30, 
+0x30,  0x35,  0x61,  0x30,  0x63,  0x62,  0x33,  0x39, 
+0x35,  0x38,  0x37,  0x61,  0x61,  0x62,  0x30,  0x30, 
+0x62,  0x64,  0x35,  0x34,  0x63,  0x38,  0x34,  0x38, 
+0x62,  0x35,  0x39,  0x65,  0x38,  0x61,  0x64,  0x61, 
+0x65,  0x64,  0x34,  0x37,  0x34,  0x30,  0x33,  0x32, 
+0x32,  0x38,  0x35,  0x36,  0x37,  0x64,  0x64,  0x63, 
+0x37,  0x33,  0x39,  0x63,  0x32,  0x61,  0x33,  0x34, 
+0x34,  0x66,  0x66,  0x35,  0x39,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x43,  0x6f, 
+0x6d,  0x70,  0x72,  0x65,  0x73,  0x73,  0x65,  0x64, 
+0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x39, 
+0x33,  0x32,  0x50,  0x4c,  0x43,  0x4c,  0x41,  0x31, 
+0x39,  0x79,  0x50,  0x4e,  0x71,  0x56,  0x36,  0x37, 
+0x71,  0x77,  0x48,  0x42,  0x53,  0x47,  0x6a,  0x78, 
+0x69,  0x38,  0x32,  0x4c,  0x56,  0x7a,  0x57,  0x42, 
+0x46,  0x37,  0x6a,  0x6f,  0x73,  0x4c,  0x39,  0x61, 
+0x62,  0x34,  0x51,  0x31,  0x6b,  0x78,  0x67,  0x50, 
+0x47,  0x46,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x64, 
+0x38,  0x36,  0x37,  0x37,  0x65,  0x30,  0x37,  0x36, 
+0x65,  0x62,  0x33,  0x39,  0x37,  0x37,  0x30,  0x62, 
+0x66,  0x37,  0x65,  0x39,  0x66,  0x39,  0x65,  0x38, 
+0x64,  0x33,  0x66,  0x32,  0x63,  0x66,  0x32,  0x35, 
+0x37,  0x65,  0x66,  0x66,  0x61,  0x62,  0x39,  0x62, 
+0x34,  0x63,  0x32,  0x32,  0x30,  0x66,  0x64,  0x33, 
+0x34,  0x33,  0x39,  0x63,  0x63,  0x66,  0x63,  0x32, 
+0x30,  0x38,  0x63,  0x39,  0x38,  0x34,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x73,  0x69,  0x67,  0x6e,  0x65,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65,  0x73, 
+0x73,  0x65,  0x64,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x74,  0x72, 
+0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x56,  0x69,  0x55,  0x70, 
+0x45,  0x79,  0x38,  0x55,  0x52,  0x53,  0x73,  0x4c, 
+0x6a,  0x55,  0x76,  0x78,  0x77,  0x4c,  0x37,  0x63, 
+0x45,  0x75,  0x4e,  0x67,  0x43,  0x56,  0x71,  0x4d, 
+0x37,  0x6f,  0x4b,  0x42,  0x7a,  0x64,  0x31,  0x5a, 
+0x50,  0x62,  0x41,  0x34,  0x6b,  0x68,  0x63,  0x51, 
+0x73,  0x51,  0x4a,  0x75,  0x6a,  0x31,  0x6a,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x66,  0x32,  0x62,  0x33,  0x36, 
+0x61,  0x64,  0x65,  0x38,  0x33,  0x39,  0x33,  0x65, 
+0x32,  0x39,  0x64,  0x63,  0x37,  0x31,  0x65,  0x35, 
+0x32,  0x63,  0x62,  0x37,  0x35,  0x62,  0x61,  0x31, 
+0x31,  0x30,  0x39,  0x62,  0x61,  0x32,  0x31,  0x30, 
+0x32,  0x30,  0x33,  0x63,  0x64,  0x37,  0x64,  0x30, 
+0x61,  0x35,  0x61,  0x65,  0x38,  0x38,  0x31,  0x61, 
+0x64,  0x36,  0x38,  0x34,  0x36,  0x35,  0x31,  0x36, 
+0x32,  0x30,  0x33,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x73,  0x69, 
+0x67,  0x6e,  0x65,  0x74,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x43,  0x6f, 
+0x6d,  0x70,  0x72,  0x65,  0x73,  0x73,  0x65,  0x64, 
+0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x39, 
+0x32,  0x6a,  0x64,  0x64,  0x44,  0x6a,  0x4a,  0x43, 
+0x56,  0x44,  0x6d,  0x4a,  0x74,  0x67,  0x76,  0x42, 
+0x48,  0x51,  0x39,  0x69,  0x35,  0x38,  0x50,  0x4d, 
+0x61,  0x73,  0x68,  0x38,  0x6b,  0x77,  0x73,  0x59, 
+0x68,  0x52,  0x64,  0x4e,  0x6f,  0x32,  0x32,  0x65, 
+0x61,  0x32,  0x4d,  0x59,  0x50,  0x58,  0x64,  0x43, 
+0x42,  0x45,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x39,  0x37, 
+0x37,  0x62,  0x66,  0x38,  0x36,  0x38,  0x36,  0x66, 
+0x31,  0x62,  0x63,  0x61,  0x64,  0x32,  0x38,  0x66, 
+0x38,  0x36,  0x63,  0x34,  0x63,  0x31,  0x34,  0x61, 
+0x66,  0x62,  0x64,  0x33,  0x33,  0x32,  0x31,  0x35, 
+0x37,  0x34,  0x36,  0x62,  0x64,  0x31,  0x39,  0x32, 
+0x30,  0x33,  0x36,  0x34,  0x37,  0x62,  0x66,  0x37, 
+0x66,  0x66,  0x39,  0x63,  0x36,  0x66,  0x64,  0x64, 
+0x63,  0x39,  0x63,  0x63,  0x38,  0x37,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x72,  0x65,  0x67,  0x74,  0x65,  0x73,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65, 
+0x73,  0x73,  0x65,  0x64,  0x22,  0x3a,  0x20,  0x66, 
+0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69, 
+0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x74, 
+0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x63,  0x56,  0x77,  0x41, 
+0x75,  0x4d,  0x6f,  0x55,  0x71,  0x52,  0x6f,  0x33, 
+0x39,  0x39,  0x58,  0x37,  0x76,  0x58,  0x7a,  0x75, 
+0x7a,  0x51,  0x79,  0x50,  0x45,  0x76,  0x5a,  0x4a, 
+0x4d,  0x58,  0x4d,  0x38,  0x63,  0x38,  0x32,  0x7a, 
+0x48,  0x7a,  0x52,  0x6b,  0x46,  0x43,  0x78,  0x50, 
+0x43,  0x53,  0x47,  0x78,  0x38,  0x41,  0x36,  0x79, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x66,  0x39,  0x33,  0x61, 
+0x63,  0x62,  0x62,  0x63,  0x65,  0x30,  0x32,  0x62, 
+0x38,  0x63,  0x62,  0x39,  0x64,  0x64,  0x63,  0x61, 
+0x33,  0x66,  0x61,  0x64,  0x34,  0x39,  0x35,  0x34, 
+0x34,  0x31,  0x65,  0x33,  0x32,  0x34,  0x63,  0x63, 
+0x30,  0x31,  0x65,  0x62,  0x36,  0x34,  0x30,  0x62, 
+0x30,  0x61,  0x37,  0x62,  0x34,  0x63,  0x39,  0x66, 
+0x30,  0x65,  0x33,  0x31,  0x36,  0x34,  0x34,  0x63, 
+0x38,  0x32,  0x32,  0x61,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68, 
+0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72, 
+0x65,  0x67,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x43,  0x6f,  0x6d,  0x70,  0x72,  0x65,  0x73,  0x73, 
+0x65,  0x64,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75, 
+0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x62,  0x63,  0x31,  0x71,  0x7a,  0x33,  0x37, 
+0x37,  0x7a,  0x77,  0x65,  0x35,  0x61,  0x77,  0x72, 
+0x36,  0x38,  0x64,  0x6e,  0x67,  0x67,  0x65,  0x6e, 
+0x67,  0x71,  0x78,  0x39,  0x76,  0x72,  0x6a,  0x74, 
+0x30,  0x35,  0x6b,  0x39,  0x38,  0x71,  0x33,  0x73, 
+0x77,  0x32,  0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30, 
+0x30,  0x31,  0x34,  0x31,  0x34,  0x37,  0x64,  0x65, 
+0x31,  0x33,  0x62,  0x33,  0x34,  0x65,  0x62,  0x38, 
+0x37,  0x61,  0x33,  0x62,  0x36,  0x36,  0x38,  0x34, 
+0x36,  0x36,  0x36,  0x38,  0x30,  0x31,  0x38,  0x61, 
+0x63,  0x31,  0x63,  0x39,  0x36,  0x66,  0x61,  0x35, 
+0x38,  0x61,  0x37,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61, 
+0x69,  0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x31, 
+0x71,  0x6b,  0x6d,  0x68,  0x73,  0x6b,  0x70,  0x64, 
+0x7a,  0x67,  0x38,  0x6b,  0x64,  0x6b,  0x66,  0x79, 
+0x77,  0x68,  0x75,  0x30,  0x39,  0x6b,  0x73,  0x77, 
+0x77,  0x6e,  0x39,  0x71,  0x61,  0x6e,  0x39,  0x76, 
+0x6e,  0x6b,  0x72,  0x66,  0x36,  0x6d,  0x6b,  0x34, 
+0x30,  0x6a,  0x76,  0x6e,  0x72,  0x30,  0x36,  0x73, 
+0x36,  0x73,  0x7a,  0x35,  0x73,  0x73,  0x66,  0x38, 
+0x32,  0x79,  0x61,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30, 
+0x30,  0x32,  0x30,  0x62,  0x36,  0x65,  0x66,  0x30, 
+0x62,  0x30,  0x35,  0x61,  0x32,  0x34,  0x31,  0x65, 
+0x63,  0x64,  0x62,  0x32,  0x34,  0x38,  0x65,  0x62, 
+0x66,  0x31,  0x65,  0x35,  0x62,  0x34,  0x31,  0x63, 
+0x65,  0x39,  0x39,  0x34,  0x31,  0x64,  0x39,  0x39, 
+0x35,  0x39,  0x33,  0x62,  0x30,  0x64,  0x33,  0x61, 
+0x64,  0x64,  0x61,  0x61,  0x66,  0x39,  0x33,  0x32, 
+0x36,  0x33,  0x37,  0x65,  0x61,  0x31,  0x61,  0x38, 
+0x30,  0x61,  0x39,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61, 
+0x69,  0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x31, 
+0x70,  0x73,  0x38,  0x63,  0x6e,  0x64,  0x61,  0x73, 
+0x36,  0x30,  0x63,  0x6e,  0x74,  0x6b,  0x38,  0x78, 
+0x37,  0x39,  0x73,  0x67,  0x39,  0x66,  0x35,  0x65, 
+0x35,  0x6a,  0x7a,  0x37,  0x78,  0x30,  0x35,  0x30, 
+0x7a,  0x38,  0x61,  0x67,  0x79,  0x75,  0x67,  0x6c, 
+0x6e,  0x32,  0x75,  0x6b,  0x6b,  0x6b,  0x73,  0x32, 
+0x33,  0x72,  0x72,  0x79,  0x71,  0x70,  0x65,  0x6a, 
+0x7a,  0x6b,  0x63,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35, 
+0x31,  0x32,  0x30,  0x38,  0x31,  0x66,  0x31,  0x33, 
+0x36,  0x66,  0x36,  0x31,  0x61,  0x37,  0x65,  0x32, 
+0x36,  0x62,  0x62,  0x31,  0x63,  0x64,  0x65,  0x32, 
+0x63,  0x31,  0x30,  0x35,  0x34,  0x64,  0x33,  0x33, 
+0x34,  0x39,  0x30,  0x62,  0x63,  0x36,  0x37,  0x64, 
+0x31,  0x65,  0x32,  0x33,  0x66,  0x35,  0x30,  0x34, 
+0x65,  0x32,  0x33,  0x66,  0x33,  0x35,  0x37,  0x32, 
+0x64,  0x36,  0x62,  0x34,  0x31,  0x35,  0x31,  0x31, 
+0x38,  0x63,  0x38,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61, 
+0x69,  0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x31, 
+0x7a,  0x6e,  0x34,  0x74,  0x73,  0x63,  0x7a,  0x67, 
+0x65,  0x39,  0x6c,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35, 
+0x32,  0x30,  0x32,  0x39,  0x64,  0x35,  0x37,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x6d,  0x61,  0x69,  0x6e,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x72, 
+0x79,  0x43,  0x61,  0x73,  0x65,  0x46,  0x6c,  0x69, 
+0x70,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x62,  0x31,  0x71,  0x36,  0x78,  0x77, 
+0x30,  0x77,  0x77,  0x64,  0x39,  0x6e,  0x39,  0x64, 
+0x37,  0x67,  0x65,  0x38,  0x37,  0x64,  0x72,  0x79, 
+0x7a,  0x34,  0x76,  0x6d,  0x35,  0x76,  0x74,  0x61, 
+0x68,  0x7a,  0x68,  0x76,  0x7a,  0x36,  0x79,  0x65, 
+0x74,  0x74,  0x33,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30, 
+0x30,  0x31,  0x34,  0x64,  0x31,  0x39,  0x63,  0x66, 
+0x37,  0x33,  0x39,  0x61,  0x35,  0x39,  0x39,  0x35, 
+0x62,  0x65,  0x34,  0x36,  0x34,  0x66,  0x65,  0x36, 
+0x38,  0x63,  0x38,  0x32,  0x61,  0x62,  0x33,  0x37, 
+0x34,  0x36,  0x32,  0x66,  0x62,  0x37,  0x31,  0x35, 
+0x64,  0x38,  0x32,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74,  0x65, 
+0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31, 
+0x71,  0x77,  0x6e,  0x39,  0x7a,  0x71,  0x39,  0x66, 
+0x75,  0x35,  0x75,  0x6b,  0x33,  0x35,  0x79,  0x6b, 
+0x70,  0x67,  0x73,  0x63,  0x37,  0x72,  0x7a,  0x34, 
+0x75,  0x61,  0x77,  0x79,  0x34,  0x79,  0x68,  0x30, 
+0x72,  0x35,  0x6d,  0x35,  0x65,  0x72,  0x32,  0x36, 
+0x37,  0x36,  0x38,  0x68,  0x35,  0x75,  0x72,  0x35, 
+0x30,  0x73,  0x75,  0x33,  0x71,  0x6a,  0x36,  0x65, 
+0x76,  0x75,  0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30, 
+0x30,  0x32,  0x30,  0x37,  0x34,  0x63,  0x61,  0x32, 
+0x30,  0x31,  0x35,  0x33,  0x63,  0x61,  0x37,  0x32, 
+0x64,  0x31,  0x61,  0x31,  0x32,  0x63,  0x31,  0x34, 
+0x34,  0x33,  0x31,  0x65,  0x31,  0x38,  0x61,  0x62, 
+0x63,  0x65,  0x62,  0x38,  0x39,  0x35,  0x32,  0x35, 
+0x64,  0x65,  0x33,  0x61,  0x36,  0x65,  0x39,  0x39, 
+0x31,  0x61,  0x62,  0x35,  0x65,  0x64,  0x31,  0x65, 
+0x66,  0x34,  0x65,  0x30,  0x65,  0x38,  0x66,  0x38, 
+0x37,  0x32,  0x32,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74,  0x65, 
+0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31, 
+0x70,  0x6d,  0x63,  0x64,  0x63,  0x35,  0x64,  0x38, 
+0x67,  0x72,  0x39,  0x32,  0x72,  0x74,  0x65,  0x6d, 
+0x66,  0x73,  0x6e,  0x68,  0x70,  0x65,  0x71,  0x61, 
+0x6e,  0x76,  0x73,  0x30,  0x6e,  0x72,  0x38,  0x32, 
+0x75,  0x70,  0x6e,  0x35,  0x64,  0x6b,  0x74,  0x78, 
+0x6c,  0x75,  0x7a,  0x39,  0x6e,  0x30,  0x71,  0x63, 
+0x76,  0x33,  0x34,  0x6c,  0x71,  0x78,  0x6b,  0x65, 
+0x30,  0x77,  0x71,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35, 
+0x31,  0x32,  0x30,  0x64,  0x65,  0x31,  0x62,  0x38, 
+0x61,  0x33,  0x34,  0x65,  0x38,  0x31,  0x39,  0x35, 
+0x34,  0x33,  0x35,  0x65,  0x37,  0x36,  0x39,  0x38, 
+0x34,  0x65,  0x65,  0x31,  0x63,  0x38,  0x33,  0x62, 
+0x33,  0x36,  0x34,  0x31,  0x66,  0x33,  0x31,  0x39, 
+0x64,  0x35,  0x63,  0x30,  0x63,  0x65,  0x38,  0x64, 
+0x62,  0x32,  0x63,  0x64,  0x66,  0x65,  0x30,  0x38, 
+0x62,  0x33,  0x37,  0x38,  0x33,  0x30,  0x63,  0x38, 
+0x64,  0x37,  0x65,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x74,  0x65, 
+0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31, 
+0x72,  0x67,  0x78,  0x6a,  0x76,  0x74,  0x66,  0x7a, 
+0x70,  0x30,  0x78,  0x63,  0x7a,  0x7a,  0x36,  0x64, 
+0x6c,  0x7a,  0x71,  0x76,  0x38,  0x64,  0x35,  0x63, 
+0x6d,  0x75,  0x79,  0x6b,  0x6b,  0x34,  0x71,  0x6b, 
+0x6b,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x33,  0x31, 
+0x30,  0x34,  0x31,  0x61,  0x34,  0x63,  0x35,  0x61, 
+0x34,  0x34,  0x31,  0x37,  0x39,  0x62,  0x30,  0x32, 
+0x31,  0x36,  0x39,  0x62,  0x66,  0x31,  0x30,  0x31, 
+0x38,  0x37,  0x36,  0x64,  0x33,  0x31,  0x62,  0x65, 
+0x31,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e, 
+0x22,  0x3a,  0x20,  0x22,  0x74,  0x65,  0x73,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65,  0x46, 
+0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74,  0x72, 
+0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x74,  0x62,  0x31,  0x71,  0x61, 
+0x39,  0x64,  0x6c,  0x79,  0x74,  0x36,  0x66,  0x79, 
+0x64,  0x65,  0x73,  0x74,  0x75,  0x6c,  0x34,  0x79, 
+0x34,  0x77,  0x68,  0x37,  0x32,  0x79,  0x73,  0x68, 
+0x68,  0x30,  0x34,  0x34,  0x77,  0x33,  0x32,  0x6e, 
+0x70,  0x38,  0x65,  0x74,  0x6b,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x30,  0x30,  0x31,  0x34,  0x65,  0x39,  0x35, 
+0x62,  0x66,  0x32,  0x32,  0x66,  0x34,  0x39,  0x32, 
+0x33,  0x37,  0x33,  0x30,  0x35,  0x66,  0x33,  0x66, 
+0x35,  0x32,  0x35,  0x35,  0x64,  0x37,  0x66,  0x32, 
+0x38,  0x39,  0x30,  0x62,  0x64,  0x64,  0x66,  0x35, 
+0x61,  0x62,  0x61,  0x32,  0x61,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x73,  0x69,  0x67,  0x6e,  0x65,  0x74,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x72, 
+0x79,  0x43,  0x61,  0x73,  0x65,  0x46,  0x6c,  0x69, 
+0x70,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x74,  0x62,  0x31,  0x71,  0x75,  0x34,  0x70, 
+0x32,  0x36,  0x6e,  0x30,  0x30,  0x33,  0x33,  0x37, 
+0x32,  0x30,  0x78,  0x6d,  0x30,  0x72,  0x6a,  0x67, 
+0x6b,  0x64,  0x73,  0x35,  0x65,  0x68,  0x64,  0x77, 
+0x66,  0x30,  0x33,  0x39,  0x6b,  0x32,  0x66,  0x67, 
+0x76,  0x37,  0x35,  0x75,  0x6d,  0x35,  0x6b,  0x72, 
+0x72,  0x76,  0x66,  0x68,  0x72,  0x72,  0x6a,  0x37, 
+0x71,  0x63,  0x6b,  0x6c,  0x39,  0x72,  0x32,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x30,  0x30,  0x32,  0x30,  0x65, 
+0x35,  0x34,  0x32,  0x61,  0x64,  0x34,  0x64,  0x65, 
+0x66,  0x38,  0x63,  0x37,  0x63,  0x61,  0x37,  0x39, 
+0x62,  0x36,  0x66,  0x31,  0x63,  0x39,  0x31,  0x36, 
+0x36,  0x63,  0x32,  0x39,  0x39,  0x62,  0x62,  0x35, 
+0x63,  0x39,  0x37,  0x63,  0x34,  0x62,  0x36,  0x35, 
+0x32,  0x35,  0x30,  0x63,  0x66,  0x35,  0x33,  0x39, 
+0x62,  0x61,  0x35,  0x38,  0x36,  0x33,  0x36,  0x32, 
+0x36,  0x65,  0x33,  0x31,  0x63,  0x62,  0x63,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x73,  0x69,  0x67,  0x6e,  0x65,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65,  0x46, 
+0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74,  0x72, 
+0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x74,  0x62,  0x31,  0x70,  0x6a, 
+0x79,  0x75,  0x6b,  0x6d,  0x34,  0x6e,  0x34,  0x66, 
+0x6c,  0x77,  0x64,  0x30,  0x65,  0x79,  0x33,  0x6c, 
+0x72,  0x6c,  0x30,  0x36,  0x63,  0x39,  0x6b,  0x61, 
+0x6c,  0x72,  0x36,  0x30,  0x67,  0x67,  0x6d,  0x6c, 
+0x6b,  0x63,  0x78,  0x71,  0x32,  0x72,  0x68,  0x68, 
+0x78,  0x6d,  0x79,  0x34,  0x6c,  0x76,  0x6b,  0x6d, 
+0x6b,  0x70,  0x71,  0x65,  0x78,  0x64,  0x7a,  0x71, 
+0x79,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x35,  0x31,  0x32, 
+0x30,  0x39,  0x31,  0x33,  0x39,  0x36,  0x64,  0x64, 
+0x36,  0x37,  0x35,  0x34,  0x66,  0x64,  0x63,  0x64, 
+0x37,  0x65,  0x34,  0x39,  0x31,  0x66,  0x38,  0x66, 
+0x65,  0x66,  0x64,  0x36,  0x30,  0x62,  0x36,  0x65, 
+0x66,  0x63,  0x37,  0x61,  0x37,  0x61,  0x31,  0x31, 
+0x62,  0x66,  0x64,  0x62,  0x30,  0x36,  0x30,  0x32, 
+0x38,  0x37,  0x37,  0x62,  0x39,  0x62,  0x36,  0x34, 
+0x61,  0x66,  0x64,  0x39,  0x36,  0x64,  0x64,  0x38, 
+0x32,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e, 
+0x22,  0x3a,  0x20,  0x22,  0x73,  0x69,  0x67,  0x6e, 
+0x65,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x62,  0x31, 
+0x72,  0x34,  0x6b,  0x37,  0x35,  0x73,  0x35,  0x73, 
+0x79,  0x76,  0x65,  0x77,  0x73,  0x76,  0x78,  0x75, 
+0x66,  0x64,  0x63,  0x33,  0x78,  0x66,  0x68,  0x66, 
+0x34,  0x74,  0x77,  0x34,  0x75,  0x33,  0x30,  0x61, 
+0x6c,  0x77,  0x33,  0x39,  0x78,  0x6e,  0x79,  0x33, 
+0x64,  0x6e,  0x78,  0x72,  0x6c,  0x36,  0x68,  0x61, 
+0x75,  0x37,  0x73,  0x79,  0x73,  0x74,  0x79,  0x6d, 
+0x66,  0x64,  0x76,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x35, 
+0x33,  0x32,  0x30,  0x61,  0x64,  0x62,  0x64,  0x34, 
+0x38,  0x35,  0x32,  0x30,  0x34,  0x36,  0x36,  0x35, 
+0x64,  0x30,  0x36,  0x31,  0x62,  0x38,  0x39,  0x36, 
+0x65,  0x32,  0x32,  0x36,  0x34,  0x64,  0x64,  0x33, 
+0x35,  0x35,  0x62,  0x61,  0x62,  0x63,  0x38,  0x62, 
+0x66,  0x62,  0x66,  0x37,  0x34,  0x34,  0x61,  0x36, 
+0x39,  0x39,  0x32,  0x32,  0x64,  0x39,  0x39,  0x38, 
+0x37,  0x66,  0x64,  0x35,  0x66,  0x62,  0x63,  0x66, 
+0x34,  0x30,  0x39,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x73,  0x69, 
+0x67,  0x6e,  0x65,  0x74,  0x22,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50,  0x72, 
+0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20, 
+0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x74,  0x72,  0x79,  0x43, 
+0x61,  0x73,  0x65,  0x46,  0x6c,  0x69,  0x70,  0x22, 
+0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7d, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x62, 
+0x63,  0x72,  0x74,  0x31,  0x71,  0x6e,  0x6b,  0x33, 
+0x74,  0x64,  0x77,  0x77,  0x6a,  0x34,  0x37,  0x70, 
+0x70,  0x63,  0x34,  0x70,  0x71,  0x6d,  0x78,  0x6b, 
+0x6a,  0x64,  0x75,  0x73,  0x65,  0x67,  0x65,  0x64, 
+0x6e,  0x39,  0x72,  0x75,  0x35,  0x67,  0x76,  0x63, 
+0x63,  0x77,  0x61,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x30, 
+0x30,  0x31,  0x34,  0x39,  0x64,  0x61,  0x32,  0x62, 
+0x36,  0x62,  0x39,  0x64,  0x32,  0x61,  0x66,  0x38, 
+0x32,  0x31,  0x63,  0x35,  0x34,  0x32,  0x30,  0x64, 
+0x39,  0x61,  0x64,  0x32,  0x36,  0x66,  0x32,  0x31, 
+0x39,  0x34,  0x36,  0x35,  0x62,  0x33,  0x32,  0x38, 
+0x66,  0x39,  0x34,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x72,  0x65, 
+0x67,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73,  0x50, 
+0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22,  0x3a, 
+0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x74,  0x72,  0x79, 
+0x43,  0x61,  0x73,  0x65,  0x46,  0x6c,  0x69,  0x70, 
+0x22,  0x3a,  0x20,  0x74,  0x72,  0x75,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x62,  0x63,  0x72,  0x74,  0x31,  0x71,  0x7a,  0x37, 
+0x70,  0x72,  0x66,  0x73,  0x68,  0x66,  0x6b,  0x77, 
+0x73,  0x78,  0x75,  0x6b,  0x37,  0x32,  0x70,  0x74, 
+0x36,  0x6d,  0x7a,  0x72,  0x36,  0x75,  0x75,  0x6d, 
+0x71,  0x34,  0x71,  0x6c,  0x6c,  0x78,  0x65,  0x34, 
+0x76,  0x6d,  0x77,  0x71,  0x74,  0x38,  0x39,  0x74, 
+0x61,  0x74,  0x34,  0x38,  0x64,  0x33,  0x36,  0x32, 
+0x79,  0x71,  0x6c,  0x79,  0x6b,  0x6b,  0x36,  0x61, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x30,  0x30,  0x32,  0x30, 
+0x31,  0x37,  0x38,  0x32,  0x33,  0x34,  0x63,  0x32, 
+0x65,  0x39,  0x62,  0x33,  0x61,  0x30,  0x36,  0x65, 
+0x35,  0x62,  0x63,  0x61,  0x30,  0x61,  0x66,  0x35, 
+0x62,  0x31,  0x30,  0x66,  0x35,  0x63,  0x65,  0x36, 
+0x63,  0x31,  0x35,  0x30,  0x37,  0x66,  0x65,  0x36, 
+0x63,  0x64,  0x35,  0x39,  0x62,  0x37,  0x30,  0x31, 
+0x36,  0x37,  0x32,  0x61,  0x66,  0x61,  0x62,  0x61, 
+0x39,  0x64,  0x62,  0x31,  0x64,  0x32,  0x38,  0x38, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x72,  0x65,  0x67,  0x74,  0x65, 
+0x73,  0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x74,  0x72,  0x79,  0x43,  0x61,  0x73, 
+0x65,  0x46,  0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20, 
+0x74,  0x72,  0x75,  0x65,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x62,  0x63,  0x72, 
+0x74,  0x31,  0x70,  0x75,  0x6d,  0x65,  0x65,  0x33, 
+0x77,  0x6a,  0x38,  0x30,  0x78,  0x76,  0x79,  0x72, 
+0x37,  0x77,  0x6a,  0x6d,  0x6a,  0x37,  0x7a,  0x73, 
+0x6b,  0x32,  0x36,  0x78,  0x35,  0x70,  0x6e,  0x30, 
+0x39,  0x35,  0x61,  0x65,  0x67,  0x79,  0x38,  0x36, 
+0x32,  0x79,  0x68,  0x78,  0x36,  0x66,  0x32,  0x6a, 
+0x39,  0x73,  0x67,  0x63,  0x39,  0x68,  0x71,  0x36, 
+0x63,  0x6a,  0x34,  0x63,  0x6d,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x35,  0x31,  0x32,  0x30,  0x65,  0x36,  0x66, 
+0x33,  0x39,  0x38,  0x62,  0x61,  0x34,  0x37,  0x37, 
+0x39,  0x39,  0x38,  0x34,  0x31,  0x66,  0x39,  0x64, 
+0x32,  0x64,  0x63,  0x62,  0x63,  0x32,  0x38,  0x35, 
+0x39,  0x35,  0x61,  0x33,  0x35,  0x30,  0x33,  0x33, 
+0x37,  0x39,  0x36,  0x39,  0x64,  0x63,  0x61,  0x30, 
+0x38,  0x37,  0x64,  0x32,  0x38,  0x39,  0x37,  0x33, 
+0x36,  0x39,  0x32,  0x61,  0x39,  0x31,  0x36,  0x30, 
+0x38,  0x63,  0x31,  0x36,  0x65,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x63, 
+0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22, 
+0x72,  0x65,  0x67,  0x74,  0x65,  0x73,  0x74,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x74, 
+0x72,  0x79,  0x43,  0x61,  0x73,  0x65,  0x46,  0x6c, 
+0x69,  0x70,  0x22,  0x3a,  0x20,  0x74,  0x72,  0x75, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x62,  0x63,  0x72,  0x74,  0x31,  0x73, 
+0x7a,  0x71,  0x7a,  0x38,  0x68,  0x6a,  0x36,  0x34, 
+0x64,  0x32,  0x68,  0x68,  0x63,  0x36,  0x6e,  0x74, 
+0x36,  0x35,  0x76,  0x30,  0x39,  0x6a,  0x78,  0x61, 
+0x6c,  0x36,  0x36,  0x70,  0x67,  0x66,  0x66,  0x32, 
+0x78,  0x70,  0x63,  0x70,  0x39,  0x6b,  0x6a,  0x36, 
+0x34,  0x38,  0x71,  0x6b,  0x6b,  0x38,  0x6b,  0x6a, 
+0x7a,  0x78,  0x65,  0x6c,  0x73,  0x74,  0x73,  0x34, 
+0x64,  0x6b,  0x74,  0x64,  0x37,  0x39,  0x39,  0x67, 
+0x34,  0x37,  0x75,  0x61,  0x73,  0x65,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x36,  0x30,  0x32,  0x38,  0x31,  0x30, 
+0x30,  0x34,  0x37,  0x62,  0x63,  0x62,  0x35,  0x35, 
+0x36,  0x61,  0x61,  0x66,  0x37,  0x63,  0x36,  0x61, 
+0x36,  0x62,  0x64,  0x35,  0x31,  0x38,  0x66,  0x32, 
+0x63,  0x38,  0x64,  0x64,  0x66,  0x65,  0x62,  0x34, 
+0x31,  0x34,  0x32,  0x35,  0x32,  0x61,  0x33,  0x30, 
+0x37,  0x30,  0x31,  0x32,  0x64,  0x61,  0x35,  0x61, 
+0x61,  0x39,  0x63,  0x31,  0x36,  0x62,  0x31,  0x65, 
+0x64,  0x32,  0x31,  0x31,  0x62,  0x33,  0x66,  0x38, 
+0x32,  0x65,  0x31,  0x35,  0x36,  0x64,  0x39,  0x36, 
+0x64,  0x66,  0x31,  0x34,  0x61,  0x38,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a,  0x20, 
+0x22,  0x72,  0x65,  0x67,  0x74,  0x65,  0x73,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x74,  0x72,  0x79,  0x43,  0x61,  0x73,  0x65,  0x46, 
+0x6c,  0x69,  0x70,  0x22,  0x3a,  0x20,  0x74,  0x72, 
+0x75,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x31,  0x32,  0x61,  0x67,  0x5a, 
+0x54,  0x61,  0x6a,  0x74,  0x52,  0x45,  0x33,  0x53, 
+0x54,  0x53,  0x63,  0x68,  0x77,  0x57,  0x4e,  0x57, 
+0x6e,  0x72,  0x6d,  0x34,  0x36,  0x37,  0x7a,  0x7a, 
+0x54,  0x51,  0x39,  0x31,  0x36,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x37,  0x36,  0x61,  0x39,  0x31,  0x34,  0x31, 
+0x31,  0x35,  0x36,  0x65,  0x30,  0x30,  0x66,  0x37, 
+0x30,  0x30,  0x36,  0x31,  0x65,  0x35,  0x66,  0x61, 
+0x62,  0x61,  0x38,  0x62,  0x37,  0x31,  0x35,  0x39, 
+0x33,  0x61,  0x38,  0x63,  0x37,  0x35,  0x35,  0x34, 
+0x62,  0x34,  0x37,  0x30,  0x39,  0x30,  0x63,  0x38, 
+0x38,  0x61,  0x63,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x22,  0x63,  0x68,  0x61, 
+0x69,  0x6e,  0x22,  0x3a,  0x20,  0x22,  0x6d,  0x61, 
+0x69,  0x6e,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76, 
+0x6b,  0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61, 
+0x6c,  0x73,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x22,  0x33,  0x4e,  0x58,  0x71, 
+0x42,  0x36,  0x69,  0x5a,  0x69,  0x50,  0x59,  0x62, 
+0x4b,  0x72,  0x75,  0x4e,  0x54,  0x33,  0x64,  0x39, 
+0x78,  0x4e,  0x42,  0x54,  0x6d,  0x74,  0x62,  0x37, 
+0x33,  0x78,  0x4d,  0x76,  0x76,  0x66,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x61,  0x39,  0x31,  0x34,  0x65,  0x34, 
+0x39,  0x64,  0x65,  0x63,  0x63,  0x39,  0x65,  0x35, 
+0x64,  0x39,  0x37,  0x65,  0x30,  0x35,  0x34,  0x37, 
+0x64,  0x33,  0x36,  0x34,  0x32,  0x66,  0x33,  0x61, 
+0x34,  0x37,  0x39,  0x35,  0x62,  0x31,  0x33,  0x61, 
+0x65,  0x36,  0x32,  0x62,  0x63,  0x61,  0x38,  0x37, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x6d,  0x61,  0x69,  0x6e,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69, 
+0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79, 
+0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x6d,  0x6a,  0x67,  0x74,  0x34,  0x42,  0x6f, 
+0x43,  0x59,  0x78,  0x6a,  0x7a,  0x57,  0x76,  0x4a, 
+0x46,  0x6f,  0x68,  0x36,  0x38,  0x78,  0x37,  0x63, 
+0x6a,  0x35,  0x47,  0x65,  0x61,  0x4b,  0x44,  0x59, 
+0x68,  0x79,  0x78,  0x22,  0x2c,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x37, 
+0x36,  0x61,  0x39,  0x31,  0x34,  0x32,  0x64,  0x63, 
+0x31,  0x31,  0x66,  0x63,  0x37,  0x62,  0x38,  0x30, 
+0x37,  0x32,  0x66,  0x37,  0x33,  0x33,  0x66,  0x36, 
+0x39,  0x30,  0x66,  0x66,  0x62,  0x30,  0x35,  0x39, 
+0x31,  0x63,  0x30,  0x30,  0x66,  0x34,  0x30,  0x36, 
+0x32,  0x32,  0x39,  0x35,  0x63,  0x38,  0x38,  0x61, 
+0x63,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e, 
+0x22,  0x3a,  0x20,  0x22,  0x74,  0x65,  0x73,  0x74, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b,  0x65, 
+0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73, 
+0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x32,  0x4e,  0x43,  0x54,  0x36,  0x46, 
+0x64,  0x51,  0x35,  0x4d,  0x78,  0x6f,  0x72,  0x48, 
+0x67,  0x6e,  0x46,  0x78,  0x4c,  0x65,  0x48,  0x79, 
+0x47,  0x77,  0x54,  0x47,  0x52,  0x64,  0x6b,  0x48, 
+0x63,  0x72,  0x4a,  0x44,  0x48,  0x22,  0x2c,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x61,  0x39,  0x31,  0x34,  0x64,  0x32,  0x61, 
+0x38,  0x65,  0x63,  0x39,  0x39,  0x32,  0x62,  0x30, 
+0x38,  0x39,  0x34,  0x61,  0x30,  0x64,  0x39,  0x33, 
+0x39,  0x31,  0x63,  0x61,  0x35,  0x64,  0x39,  0x63, 
+0x34,  0x35,  0x63,  0x33,  0x38,  0x38,  0x63,  0x34, 
+0x31,  0x62,  0x65,  0x37,  0x65,  0x38,  0x37,  0x22, 
+0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22,  0x3a, 
+0x20,  0x22,  0x74,  0x65,  0x73,  0x74,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x69,  0x73, 
+0x50,  0x72,  0x69,  0x76,  0x6b,  0x65,  0x79,  0x22, 
+0x3a,  0x20,  0x66,  0x61,  0x6c,  0x73,  0x65,  0x0a, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x7d,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x5d,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x5b,  0x0a,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x22, 
+0x6d,  0x70,  0x6f,  0x6d,  0x69,  0x41,  0x37,  0x77, 
+0x71,  0x44,  0x6e,  0x4d,  0x63,  0x78,  0x61,  0x4e, 
+0x4c,  0x43,  0x32,  0x33,  0x65,  0x42,  0x75,  0x58, 
+0x41,  0x62,  0x34,  0x55,  0x36,  0x48,  0x34,  0x5a, 
+0x71,  0x57,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x22,  0x37,  0x36, 
+0x61,  0x39,  0x31,  0x34,  0x36,  0x35,  0x65,  0x37, 
+0x35,  0x65,  0x33,  0x34,  0x30,  0x34,  0x31,  0x35, 
+0x65,  0x64,  0x32,  0x39,  0x37,  0x63,  0x35,  0x38, 
+0x64,  0x36,  0x61,  0x31,  0x34,  0x64,  0x33,  0x63, 
+0x31,  0x37,  0x63,  0x65,  0x65,  0x61,  0x61,  0x31, 
+0x37,  0x62,  0x62,  0x64,  0x38,  0x38,  0x61,  0x63, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x73,  0x69,  0x67,  0x6e,  0x65, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x5b,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x22,  0x32,  0x4e,  0x31,  0x70,  0x47, 
+0x41,  0x41,  0x35,  0x75,  0x61,  0x74,  0x62,  0x55, 
+0x32,  0x50,  0x4b,  0x76,  0x4d,  0x41,  0x39,  0x42, 
+0x6e,  0x4a,  0x6d,  0x48,  0x63,  0x4b,  0x36,  0x79, 
+0x48,  0x66,  0x4d,  0x69,  0x5a,  0x61,  0x22,  0x2c, 
+0x0a,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x61,  0x39,  0x31,  0x34,  0x35,  0x65, 
+0x30,  0x30,  0x38,  0x62,  0x36,  0x63,  0x63,  0x32, 
+0x33,  0x32,  0x31,  0x36,  0x34,  0x35,  0x37,  0x30, 
+0x62,  0x65,  0x66,  0x63,  0x32,  0x33,  0x64,  0x32, 
+0x31,  0x36,  0x30,  0x36,  0x30,  0x62,  0x66,  0x34, 
+0x65,  0x61,  0x37,  0x39,  0x33,  0x62,  0x38,  0x37, 
+0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7b,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x22,  0x63,  0x68,  0x61,  0x69,  0x6e,  0x22, 
+0x3a,  0x20,  0x22,  0x73,  0x69,  0x67,  0x6e,  0x65, 
+0x74,  0x22,  0x2c,  0x0a,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x22,  0x69,  0x73,  0x50,  0x72,  0x69,  0x76,  0x6b, 
+0x65,  0x79,  0x22,  0x3a,  0x20,  0x66,  0x61,  0x6c, 
+0x73,  0x65,  0x0a,  0x20,  0x20,  0x20,  0x20,  0x20, 
+0x20,  0x20,  0x20,  0x7d,  0x0a,  0x20,  0x20,  0x20, 
+0x20,  0x5d,  0x0a,  0x5d,  0x0a, 
+};};